@@ -0,0 +1,259 @@
+#include "barcode_batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include "barcode_logger.h"
+#include "barcode_queue.h"
+
+namespace fs = std::filesystem;
+
+BatchScanOptions defaultBatchScanOptions() {
+    BatchScanOptions options;
+    options.decode_workers = 0;
+    options.loader_threads = 2;
+    options.prefetch_depth = 16;
+    options.reduction = 1;
+    return options;
+}
+
+static bool isImageFile(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".jpg" || extension == ".jpeg" || extension == ".png" ||
+           extension == ".bmp" || extension == ".tif" || extension == ".tiff";
+}
+
+std::vector<std::string> listBatchInputs(const std::string& dir_or_manifest) {
+    std::vector<std::string> paths;
+    fs::path input(dir_or_manifest);
+
+    if (fs::is_directory(input)) {
+        for (const auto& entry : fs::directory_iterator(input)) {
+            if (entry.is_regular_file() && isImageFile(entry.path())) {
+                paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    std::ifstream manifest(dir_or_manifest);
+    if (!manifest) {
+        throw std::runtime_error("Could not open batch input: " + dir_or_manifest);
+    }
+
+    std::string line;
+    while (std::getline(manifest, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        fs::path path(line);
+        paths.push_back(path.is_absolute() ? line : (input.parent_path() / path).string());
+    }
+    return paths;
+}
+
+static void appendJsonString(std::string& out, std::string_view text) {
+    out += '"';
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+std::string formatBatchJsonLine(const std::string& file, const std::string& status,
+                                const std::vector<BarcodeResult>& results, int reduction) {
+    std::string line = "{\"file\":";
+    appendJsonString(line, file);
+    line += ",\"status\":";
+    appendJsonString(line, status);
+    line += ",\"results\":[";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BarcodeResult& result = results[i];
+        if (i > 0) line += ',';
+        line += "{\"symbology\":";
+        appendJsonString(line, result.symbology_name);
+        line += ",\"data\":";
+        appendJsonString(line, result.data);
+        line += ",\"x\":" + std::to_string(result.location.x * reduction);
+        line += ",\"y\":" + std::to_string(result.location.y * reduction);
+        line += ",\"width\":" + std::to_string(result.location.width * reduction);
+        line += ",\"height\":" + std::to_string(result.location.height * reduction);
+        line += ",\"inverted\":";
+        line += result.is_color_inverted ? "true" : "false";
+        line += '}';
+    }
+
+    line += "]}";
+    return line;
+}
+
+static int imreadFlags(int reduction) {
+    switch (reduction) {
+        case 2: return cv::IMREAD_REDUCED_GRAYSCALE_2;
+        case 4: return cv::IMREAD_REDUCED_GRAYSCALE_4;
+        case 8: return cv::IMREAD_REDUCED_GRAYSCALE_8;
+        default: return cv::IMREAD_GRAYSCALE;
+    }
+}
+
+BarcodeBatchScanner::BarcodeBatchScanner(std::shared_ptr<RecognitionContext> ctx,
+                                         std::shared_ptr<BarcodeScannerSettings> sett,
+                                         const BatchScanOptions& batch_options)
+    : context(ctx), settings(sett), options(batch_options) {
+
+    if (!context || !settings) {
+        throw std::runtime_error("Invalid batch scanner configuration");
+    }
+    if (options.reduction != 1 && options.reduction != 2 && options.reduction != 4 && options.reduction != 8) {
+        throw std::runtime_error("Batch reduction must be 1, 2, 4 or 8");
+    }
+    options.loader_threads = std::max<size_t>(1, options.loader_threads);
+    options.prefetch_depth = std::max<size_t>(1, options.prefetch_depth);
+}
+
+size_t BarcodeBatchScanner::run(const std::vector<std::string>& paths, std::ostream& out) {
+    struct LoadedImage {
+        std::string path;
+        cv::Mat image;  // Empty if the file could not be decoded
+    };
+
+    if (paths.empty()) return 0;
+
+    size_t worker_count = options.decode_workers;
+    if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    auto settings_snapshot = std::make_shared<BarcodeScannerSettings>(*settings);
+    // Workers see unrelated images in any order, so there is nothing to track
+    settings_snapshot->setTemporalTrackingEnabled(false);
+    std::vector<std::unique_ptr<BarcodeScanner>> scanners;
+    for (size_t i = 0; i < worker_count; ++i) {
+        scanners.push_back(std::make_unique<BarcodeScanner>(context, settings_snapshot));
+        scanners.back()->setConcurrentInversion(worker_count == 1);
+    }
+
+    bool owns_sequence = !context->isFrameSequenceStarted();
+    if (owns_sequence) context->startNewFrameSequence();
+
+    // Loaders decode ahead into a bounded queue, so JPEG decoding overlaps
+    // with scanning
+    BoundedQueue<LoadedImage> loaded(options.prefetch_depth);
+    std::atomic<size_t> next_path(0);
+    std::atomic<size_t> running_loaders(options.loader_threads);
+    std::atomic<bool> cancelled(false);
+    int flags = imreadFlags(options.reduction);
+
+    std::vector<std::thread> loaders;
+    for (size_t i = 0; i < options.loader_threads; ++i) {
+        loaders.emplace_back([&] {
+            size_t index;
+            while (!cancelled && (index = next_path.fetch_add(1)) < paths.size()) {
+                LoadedImage item;
+                item.path = paths[index];
+                try {
+                    item.image = cv::imread(item.path, flags);
+                } catch (const cv::Exception& e) {
+                    BARCODE_LOG_WARNING("Could not decode " << item.path << ": " << e.what());
+                }
+
+                int idle_rounds = 0;
+                while (!loaded.tryPush(item) && !cancelled) {
+                    backOff(idle_rounds);
+                }
+            }
+            running_loaders.fetch_sub(1);
+        });
+    }
+
+    // Every scanner takes the next loaded image as soon as it is free, so a
+    // slow image holds up only its own worker
+    std::mutex out_mutex;
+    std::atomic<size_t> files_with_codes(0);
+    size_t files_done = 0;
+    auto run_worker = [&](BarcodeScanner& scanner) {
+        std::vector<BarcodeResult> results;
+        int idle_rounds = 0;
+        for (;;) {
+            LoadedImage item;
+            if (!loaded.tryPop(item)) {
+                if (running_loaders == 0 && loaded.empty()) break;
+                backOff(idle_rounds);
+                continue;
+            }
+            idle_rounds = 0;
+
+            std::string line;
+            if (item.image.empty()) {
+                line = formatBatchJsonLine(item.path, "LOAD_ERROR", std::vector<BarcodeResult>());
+            } else {
+                ScanStatus status;
+                try {
+                    status = scanner.processFrame(createImageDescription(item.image), results);
+                } catch (const std::exception& e) {
+                    BARCODE_LOG_ERROR("Scanning " << item.path << " failed: " << e.what());
+                    status = SCAN_PROCESSING_ERROR;
+                    results.clear();
+                }
+                if (!results.empty()) ++files_with_codes;
+                line = formatBatchJsonLine(item.path, getScanStatusName(status), results, options.reduction);
+            }
+            line += '\n';
+
+            std::lock_guard<std::mutex> lock(out_mutex);
+            out << line;
+            out.flush();
+            ++files_done;
+            BARCODE_LOG_DEBUG("Batch progress: " << files_done << "/" << paths.size() << " file(s)");
+        }
+    };
+
+    std::vector<std::thread> workers;
+    try {
+        // The first worker runs on this thread
+        for (size_t i = 1; i < worker_count; ++i) {
+            BarcodeScanner& scanner = *scanners[i];
+            workers.emplace_back([&run_worker, &scanner] { run_worker(scanner); });
+        }
+        run_worker(*scanners[0]);
+    } catch (...) {
+        cancelled = true;
+        for (auto& loader : loaders) loader.join();
+        for (auto& worker : workers) worker.join();
+        if (owns_sequence) context->endFrameSequence();
+        throw;
+    }
+
+    for (auto& worker : workers) worker.join();
+    for (auto& loader : loaders) loader.join();
+    if (owns_sequence) context->endFrameSequence();
+
+    BARCODE_LOG_INFO("Batch finished: " << files_with_codes << " of " << paths.size() << " file(s) had codes");
+    return files_with_codes;
+}
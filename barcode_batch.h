@@ -0,0 +1,59 @@
+#ifndef BARCODE_BATCH_H
+#define BARCODE_BATCH_H
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "barcode_scanner_lib.h"
+
+struct BatchScanOptions {
+    size_t decode_workers;  // Scanner threads, 0 uses std::thread::hardware_concurrency()
+    size_t loader_threads;  // Threads decoding JPEG/PNG ahead of the scanners
+    size_t prefetch_depth;  // Images decoded but not yet scanned, bounds memory
+    int reduction;          // 1, 2, 4 or 8: images are read at 1/reduction size
+};
+
+BatchScanOptions defaultBatchScanOptions();
+
+// The images of a batch: every image file in a directory (sorted), or the
+// paths listed in a manifest, one per line, relative to the manifest's
+// directory; lines starting with '#' are comments. Throws if the input
+// cannot be read.
+std::vector<std::string> listBatchInputs(const std::string& dir_or_manifest);
+
+// Scans a large set of image files with one scanner per decode worker.
+// Images are decoded straight to grayscale by loader threads, each worker
+// scans the next decoded image as soon as it is free, and every file
+// produces one JSON line:
+//
+//   {"file":"a.jpg","status":"SUCCESS","results":[{"symbology":"Code128",
+//    "data":"...","x":10,"y":20,"width":300,"height":80,"inverted":false}]}
+//
+// Files that cannot be read get "status":"LOAD_ERROR". Lines are written in
+// completion order, which is not always input order. With reduction > 1
+// the image is decoded at reduced size (IMREAD_REDUCED_GRAYSCALE_*), which
+// is much cheaper for large JPEGs; locations are scaled back to the
+// original resolution.
+class BarcodeBatchScanner {
+public:
+    BarcodeBatchScanner(std::shared_ptr<RecognitionContext> ctx,
+                        std::shared_ptr<BarcodeScannerSettings> sett,
+                        const BatchScanOptions& options = defaultBatchScanOptions());
+
+    // Returns the number of files that had at least one code
+    size_t run(const std::vector<std::string>& paths, std::ostream& out);
+
+private:
+    std::shared_ptr<RecognitionContext> context;
+    std::shared_ptr<BarcodeScannerSettings> settings;
+    BatchScanOptions options;
+};
+
+// One JSON Lines record as described above, without the trailing newline
+std::string formatBatchJsonLine(const std::string& file, const std::string& status,
+                                const std::vector<BarcodeResult>& results, int reduction = 1);
+
+#endif // BARCODE_BATCH_H
@@ -0,0 +1,122 @@
+#include "barcode_buffer_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+static const size_t MIN_BLOCK_BYTES = 4096;
+static const size_t SIZE_CLASS_COUNT = sizeof(size_t) * 8 * 4;
+
+// Rounds bytes up to the next size class: 4 classes per power of two
+static size_t sizeClassFor(size_t bytes, size_t& block_bytes) {
+    bytes = std::max(bytes, MIN_BLOCK_BYTES);
+
+    int top_bit = 0;
+    while ((bytes >> (top_bit + 1)) != 0) ++top_bit;
+
+    size_t step = (size_t(1) << top_bit) / 4;
+    size_t steps = (bytes + step - 1) / step;  // 4 to 8
+    block_bytes = steps * step;
+    // 8 steps is the next power of two, which lands on that power's first class
+    return static_cast<size_t>(top_bit) * 4 + (steps - 4);
+}
+
+FrameBufferPool::Buffer::Buffer() : pool(nullptr), size_class(0) {}
+
+FrameBufferPool::Buffer::~Buffer() {
+    release();
+}
+
+FrameBufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : pool(other.pool), size_class(other.size_class),
+      storage(std::move(other.storage)), image(std::move(other.image)) {
+    other.pool = nullptr;
+}
+
+FrameBufferPool::Buffer& FrameBufferPool::Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        size_class = other.size_class;
+        storage = std::move(other.storage);
+        image = std::move(other.image);
+        other.pool = nullptr;
+    }
+    return *this;
+}
+
+void FrameBufferPool::Buffer::release() {
+    if (!pool) return;
+    image = cv::Mat();
+    pool->giveBack(size_class, storage);
+    storage = cv::Mat();
+    pool = nullptr;
+}
+
+FrameBufferPool::FrameBufferPool()
+    : idle(SIZE_CLASS_COUNT), bytes_in_use(0), peak_bytes_in_use(0), reserved_bytes(0) {}
+
+FrameBufferPool::Buffer FrameBufferPool::acquire(int rows, int cols, int type) {
+    size_t row_bytes = static_cast<size_t>(cols) * CV_ELEM_SIZE(type);
+    size_t block_bytes;
+    size_t size_class = sizeClassFor(row_bytes * static_cast<size_t>(rows), block_bytes);
+
+    Buffer buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<cv::Mat>& free_blocks = idle[size_class];
+        if (!free_blocks.empty()) {
+            buffer.storage = std::move(free_blocks.back());
+            free_blocks.pop_back();
+        } else {
+            reserved_bytes += block_bytes;
+        }
+        bytes_in_use += block_bytes;
+        peak_bytes_in_use = std::max(peak_bytes_in_use, bytes_in_use);
+    }
+
+    // Allocated outside the lock, blocks can be large
+    if (buffer.storage.empty()) buffer.storage = cv::Mat(1, static_cast<int>(block_bytes), CV_8UC1);
+
+    buffer.pool = this;
+    buffer.size_class = size_class;
+    buffer.image = cv::Mat(rows, cols, type, buffer.storage.data, row_bytes);
+    return buffer;
+}
+
+void FrameBufferPool::giveBack(size_t size_class, cv::Mat& storage) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bytes_in_use -= storage.total();
+    idle[size_class].push_back(std::move(storage));
+}
+
+size_t FrameBufferPool::getBytesInUse() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes_in_use;
+}
+
+size_t FrameBufferPool::getPeakBytesInUse() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return peak_bytes_in_use;
+}
+
+void FrameBufferPool::resetPeak() {
+    std::lock_guard<std::mutex> lock(mutex);
+    peak_bytes_in_use = bytes_in_use;
+}
+
+size_t FrameBufferPool::getReservedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reserved_bytes;
+}
+
+void FrameBufferPool::trim() {
+    std::vector<std::vector<cv::Mat>> released(SIZE_CLASS_COUNT);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& free_blocks : idle) {
+            for (const cv::Mat& block : free_blocks) reserved_bytes -= block.total();
+        }
+        idle.swap(released);
+    }
+    // Blocks are freed here, outside the lock
+}
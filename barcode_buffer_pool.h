@@ -0,0 +1,70 @@
+#ifndef BARCODE_BUFFER_POOL_H
+#define BARCODE_BUFFER_POOL_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// Size-bucketed pool of scratch images. Storage is handed out in size
+// classes a quarter of a power of two apart (at most 25% slack) and goes
+// back to its class when the buffer is released, so once every size a
+// frame needs has been seen, frames no longer touch the heap.
+//
+// Thread-safe, so a scanner's concurrent inverted pass can share its pool.
+// The pool must outlive every buffer taken from it.
+class FrameBufferPool {
+public:
+    // Scratch image on loan from the pool, returned when destroyed
+    class Buffer {
+    public:
+        Buffer();
+        ~Buffer();
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        // Header over the pooled storage. OpenCV functions writing into it
+        // must be asked for exactly this size and type, or they reallocate.
+        cv::Mat& mat() { return image; }
+        bool empty() const { return pool == nullptr; }
+        void release();
+
+    private:
+        friend class FrameBufferPool;
+
+        FrameBufferPool* pool;
+        size_t size_class;
+        cv::Mat storage;  // The whole block
+        cv::Mat image;
+    };
+
+    FrameBufferPool();
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+    // rows x cols of type, contents undefined
+    Buffer acquire(int rows, int cols, int type);
+
+    // Storage currently on loan, and the most that was since resetPeak()
+    size_t getBytesInUse() const;
+    size_t getPeakBytesInUse() const;
+    void resetPeak();
+    // Everything the pool holds, on loan or idle
+    size_t getReservedBytes() const;
+    // Frees the idle blocks, e.g. after a burst of unusually large frames
+    void trim();
+
+private:
+    void giveBack(size_t size_class, cv::Mat& storage);
+
+    mutable std::mutex mutex;
+    std::vector<std::vector<cv::Mat>> idle;  // Free blocks per size class
+    size_t bytes_in_use;
+    size_t peak_bytes_in_use;
+    size_t reserved_bytes;
+};
+
+#endif // BARCODE_BUFFER_POOL_H
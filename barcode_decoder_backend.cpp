@@ -0,0 +1,404 @@
+#include "barcode_decoder_backend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include <ZXing/ReadBarcode.h>
+
+#if BARCODE_HAVE_ZBAR
+#include <zbar.h>
+#endif
+
+#include "barcode_logger.h"
+
+extern "C" {
+#include <dmtx.h>
+}
+
+const char* getEngineName(DecoderEngine engine) {
+    switch (engine) {
+        case ENGINE_ZBAR: return "ZBar";
+        case ENGINE_ZXING: return "ZXing";
+        case ENGINE_LIBDMTX: return "libdmtx";
+        default: return "Unknown";
+    }
+}
+
+SymbologyMask getEngineSymbologies(DecoderEngine engine) {
+    switch (engine) {
+        case ENGINE_ZBAR:
+#if BARCODE_HAVE_ZBAR
+            return symbologyBit(SymbologyType::Code128) | symbologyBit(SymbologyType::Code39) |
+                   symbologyBit(SymbologyType::Code93) | symbologyBit(SymbologyType::EAN13) |
+                   symbologyBit(SymbologyType::EAN8) | symbologyBit(SymbologyType::UPCA) |
+                   symbologyBit(SymbologyType::UPCE);
+#else
+            return 0;
+#endif
+        case ENGINE_ZXING: {
+            SymbologyMask all = 0;
+            for (int i = 1; i < SYMBOLOGY_COUNT; ++i) all |= symbologyBit(static_cast<SymbologyType>(i));
+            return all;
+        }
+        case ENGINE_LIBDMTX: return symbologyBit(SymbologyType::DataMatrix);
+        default: return 0;
+    }
+}
+
+bool engineDecodesInverted(DecoderEngine engine) {
+    return engine == ENGINE_ZXING;
+}
+
+// The order main.cpp has always run the engines in: ZBar is the cheap first
+// pass for 1D labels with ZXing recovering the ones it misses, and libdmtx
+// retries the DataMatrix candidates ZXing located but could not decode.
+// barcode_bench's BM_Engine measures each pair on the corpus; re-check these
+// when a decoder is upgraded.
+EngineRoute defaultEngineRoute(SymbologyType symbology) {
+    if (getEngineSymbologies(ENGINE_ZBAR) & symbologyBit(symbology)) return {ENGINE_ZBAR, ENGINE_ZXING};
+    if (symbology == SymbologyType::DataMatrix) return {ENGINE_ZXING, ENGINE_LIBDMTX};
+    return {ENGINE_ZXING};
+}
+
+void DecodeRequest::storeText(BarcodeResult& result, std::string_view data) const {
+    result.data = text->store(data);
+    result.storage = text;
+}
+
+cv::Rect DecodeRequest::toFrame(const cv::Rect& rect) const {
+    if (to_frame == 1.0) return rect;
+    return cv::Rect(cvRound(rect.x * to_frame), cvRound(rect.y * to_frame),
+                    cvRound(rect.width * to_frame), cvRound(rect.height * to_frame));
+}
+
+// ZXing's format for every SymbologyType, in enum order, so the plan and
+// the result mapping read the same table
+static constexpr ZXing::BarcodeFormat ZXING_FORMATS[SYMBOLOGY_COUNT] = {
+    ZXing::BarcodeFormat::None,        // None
+    ZXing::BarcodeFormat::Code128,
+    ZXing::BarcodeFormat::Code39,
+    ZXing::BarcodeFormat::Code93,
+    ZXing::BarcodeFormat::None,        // EAN
+    ZXing::BarcodeFormat::EAN13,
+    ZXing::BarcodeFormat::EAN8,
+    ZXing::BarcodeFormat::UPCA,
+    ZXing::BarcodeFormat::UPCE,
+    ZXing::BarcodeFormat::DataMatrix,
+    ZXing::BarcodeFormat::QRCode,
+    ZXing::BarcodeFormat::PDF417,
+    ZXing::BarcodeFormat::Aztec,
+};
+static_assert(ZXING_FORMATS[static_cast<int>(SymbologyType::Aztec)] == ZXing::BarcodeFormat::Aztec,
+              "ZXING_FORMATS must follow SymbologyType");
+
+ZXing::BarcodeFormats getZXingFormats(SymbologyMask symbologies) {
+    ZXing::BarcodeFormats formats;
+    for (int i = 1; i < SYMBOLOGY_COUNT; ++i) {
+        if ((symbologies & symbologyBit(static_cast<SymbologyType>(i))) && ZXING_FORMATS[i] != ZXing::BarcodeFormat::None) {
+            formats |= ZXING_FORMATS[i];
+        }
+    }
+    return formats;
+}
+
+static SymbologyType convertZXingFormat(ZXing::BarcodeFormat format) {
+    for (int i = 1; i < SYMBOLOGY_COUNT; ++i) {
+        if (format != ZXing::BarcodeFormat::None && ZXING_FORMATS[i] == format) return static_cast<SymbologyType>(i);
+    }
+    return SymbologyType::None;
+}
+
+// Formats and options come from the plan. Stateless, so pyramid levels can
+// be decoded in parallel.
+class ZXingBackend : public DecoderBackend {
+public:
+    DecoderEngine engine() const override { return ENGINE_ZXING; }
+
+    void decode(const DecodeRequest& request, std::vector<BarcodeResult>& results) override {
+        const cv::Mat& image = request.image;
+        // Pass the row stride so views into larger buffers are read correctly
+        ZXing::ImageView view(image.data, image.cols, image.rows, ZXing::ImageFormat::Lum, static_cast<int>(image.step));
+        ZXing::Barcodes barcodes;
+        {
+            ScopedStageTimer zxing_timer(request.instrumentation, SCAN_STAGE_ZXING);
+            barcodes = ZXing::ReadBarcodes(view, request.plan->zxing_options);
+        }
+        BARCODE_LOG_DEBUG("ZXing found " << barcodes.size() << " barcode(s)");
+
+        // The plan leaves room for failed reads in ZXing's symbol limit, so
+        // the valid codes are capped here
+        int found = 0;
+        for (const auto& barcode : barcodes) {
+            SymbologyType symbology = convertZXingFormat(barcode.format());
+            if (!(request.symbologies & symbologyBit(symbology))) continue;
+
+            if (barcode.isValid() && !barcode.text().empty()) {
+                if (found >= request.max_codes) continue;
+                ++found;
+                BarcodeResult result;
+                request.storeText(result, barcode.text());
+                result.symbology = symbology;
+                result.symbology_name = getSymbologyName(symbology);
+                result.is_color_inverted = barcode.isInverted();
+                result.confidence = 1.0;  // ZXing doesn't provide confidence
+                result.location = request.toFrame(boundingRect(barcode.position()));
+                results.push_back(std::move(result));
+            } else if (!barcode.isValid() && symbology == SymbologyType::DataMatrix && request.candidates) {
+                // Only returned when the plan routes DataMatrix to libdmtx as well
+                request.candidates->push_back({symbology, request.toFrame(boundingRect(barcode.position())),
+                                               barcode.isInverted()});
+            }
+        }
+    }
+
+private:
+    // Positions can be rotated, the box holds all four corners
+    static cv::Rect boundingRect(const ZXing::Position& position) {
+        std::vector<cv::Point> corners;
+        for (int i = 0; i < 4; ++i) corners.push_back(cv::Point(position[i].x, position[i].y));
+        return cv::boundingRect(corners);
+    }
+};
+
+// An unbudgeted frame still stops each libdmtx search after this long, and
+// after this many regions, decoded or not; a noisy frame can otherwise
+// keep yielding regions that fail to decode for seconds
+static const std::chrono::milliseconds LIBDMTX_UNBUDGETED_SEARCH_LIMIT(2000);
+static const int LIBDMTX_MAX_REGIONS = 10;
+
+// The region search runs in short slices so a cancelled inverted pass or an
+// exhausted frame budget stops it within one slice. libdmtx keeps its scan
+// position in the decoder, so each slice resumes where the previous one
+// stopped.
+static DmtxRegion* findNextDataMatrixRegion(DmtxDecode* dec, FrameDeadline& deadline, const ScanCancellationToken* token) {
+    const long poll_interval_ms = 20;
+
+    for (;;) {
+        if (token && token->isCancelled()) return nullptr;
+
+        long slice_ms = poll_interval_ms;
+        if (!deadline.isUnlimited()) {
+            auto remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline.remaining()).count();
+            if (remaining_ms <= 0) {
+                deadline.markExhausted();
+                return nullptr;
+            }
+            slice_ms = std::min<long>(slice_ms, static_cast<long>(remaining_ms));
+        }
+
+        DmtxTime slice = dmtxTimeAdd(dmtxTimeNow(), slice_ms);
+        DmtxRegion* reg = dmtxRegionFindNext(dec, &slice);
+        if (reg) return reg;
+
+        // Returned before the slice ran out, so the whole image has been searched
+        if (!dmtxTimeExceeded(slice)) return nullptr;
+    }
+}
+
+// Fallback cascade: first retries the DataMatrix candidates an earlier
+// engine located but could not decode, and only searches the whole image
+// when the frame is still short of max_codes
+class LibdmtxBackend : public DecoderBackend {
+public:
+    DecoderEngine engine() const override { return ENGINE_LIBDMTX; }
+
+    void decode(const DecodeRequest& request, std::vector<BarcodeResult>& results) override {
+        if (!(request.symbologies & symbologyBit(SymbologyType::DataMatrix))) return;
+
+        const cv::Mat& image = request.image;
+        const cv::Rect frame(0, 0, image.cols, image.rows);
+        int found = 0;
+
+        if (request.candidates) {
+            for (const DecodeCandidate& candidate : *request.candidates) {
+                if (found >= request.max_codes) return;
+                if (candidate.symbology != SymbologyType::DataMatrix) continue;
+
+                // Grow the candidate so libdmtx sees the quiet zone and finder pattern
+                cv::Rect roi = candidate.region;
+                int margin = std::max(roi.width, roi.height) / 4 + 8;
+                roi = cv::Rect(roi.x - margin, roi.y - margin, roi.width + 2 * margin, roi.height + 2 * margin) & frame;
+                if (roi.empty()) continue;
+
+                cv::Mat region = image(roi);
+                FrameBufferPool::Buffer inverted;
+                if (candidate.is_inverted) {
+                    inverted = request.buffers->acquire(region.rows, region.cols, region.type());
+                    cv::bitwise_not(region, inverted.mat());
+                    region = inverted.mat();
+                }
+                found += decodeImage(request, region, roi.tl(), request.max_codes - found, candidate.is_inverted,
+                                     results);
+            }
+        }
+
+        if (found < request.max_codes) {
+            decodeImage(request, image, cv::Point(0, 0), request.max_codes - found, request.is_inverted, results);
+        }
+    }
+
+private:
+    // offset maps locations found in a cropped region back to request.image;
+    // returns the number of codes added
+    static int decodeImage(const DecodeRequest& request, const cv::Mat& image, cv::Point offset, int max_codes,
+                           bool is_inverted, std::vector<BarcodeResult>& results) {
+        FrameDeadline& deadline = *request.deadline;
+        if (deadline.expired()) {
+            deadline.markExhausted();
+            return 0;
+        }
+
+        ScopedStageTimer libdmtx_timer(request.instrumentation, SCAN_STAGE_LIBDMTX);
+        // libdmtx only reads the pixels, the cast is needed for its C signature
+        DmtxImage* img = dmtxImageCreate(const_cast<unsigned char*>(image.data), image.cols, image.rows, DmtxPack8bppK);
+        if (!img) return 0;
+
+        // Candidate regions are views into the frame
+        if (!image.isContinuous()) {
+            dmtxImageSetProp(img, DmtxPropRowPadding, static_cast<int>(image.step - image.cols));
+        }
+
+        DmtxDecode* dec = dmtxDecodeCreate(img, 1);
+        if (!dec) {
+            dmtxImageDestroy(&img);
+            return 0;
+        }
+
+        // Bounded by the frame budget, or by a fixed limit when the frame has
+        // none. Only the inverted pass gives up early once enough codes are found.
+        FrameDeadline unbudgeted_limit(LIBDMTX_UNBUDGETED_SEARCH_LIMIT);
+        FrameDeadline& search_deadline = deadline.isUnlimited() ? unbudgeted_limit : deadline;
+        const int max_regions = std::max(max_codes, LIBDMTX_MAX_REGIONS);
+        int found = 0;
+        for (int regions = 0; found < max_codes && regions < max_regions; ++regions) {
+            DmtxRegion* reg = findNextDataMatrixRegion(dec, search_deadline, request.is_inverted ? request.token : nullptr);
+            if (!reg) break;
+
+            DmtxMessage* msg = dmtxDecodeMatrixRegion(dec, reg, DmtxUndefined);
+            if (msg && msg->output != nullptr && msg->outputSize > 0) {
+                BarcodeResult result;
+                request.storeText(result, std::string_view(reinterpret_cast<const char*>(msg->output), msg->outputSize));
+                result.symbology = SymbologyType::DataMatrix;
+                result.symbology_name = getSymbologyName(SymbologyType::DataMatrix);
+                result.is_color_inverted = is_inverted;
+                result.confidence = 1.0;
+                // The region bounds are needed to merge these with the ZXing results.
+                // libdmtx counts rows up from the bottom of the image.
+                int top = image.rows - 1 - reg->boundMax.Y;
+                result.location = request.toFrame(cv::Rect(reg->boundMin.X + offset.x, top + offset.y,
+                                                           reg->boundMax.X - reg->boundMin.X,
+                                                           reg->boundMax.Y - reg->boundMin.Y));
+
+                results.push_back(std::move(result));
+                ++found;
+                if (request.token) request.token->reportFound(results.back());
+            }
+            if (msg) dmtxMessageDestroy(&msg);
+
+            dmtxRegionDestroy(&reg);
+        }
+
+        dmtxDecodeDestroy(&dec);
+        dmtxImageDestroy(&img);
+        return found;
+    }
+};
+
+#if BARCODE_HAVE_ZBAR
+// Configured for exactly the symbologies routed to it, so ZBar spends no
+// time on the others. Each polarity has its own ImageScanner since the
+// normal and inverted passes run at once.
+class ZBarBackend : public DecoderBackend {
+public:
+    DecoderEngine engine() const override { return ENGINE_ZBAR; }
+
+    void configure(const DecoderPlan& plan) override {
+        configureScanner(scanner, plan.engine_symbologies[ENGINE_ZBAR]);
+        configureScanner(inverted_scanner, plan.inverted_symbologies[ENGINE_ZBAR]);
+    }
+
+    void decode(const DecodeRequest& request, std::vector<BarcodeResult>& results) override {
+        // ZBar only reads the pixels but has no row stride, so only views
+        // into a larger plane are copied
+        cv::Mat gray = request.image;
+        FrameBufferPool::Buffer contiguous;
+        if (!gray.isContinuous()) {
+            contiguous = request.buffers->acquire(gray.rows, gray.cols, gray.type());
+            gray.copyTo(contiguous.mat());
+            gray = contiguous.mat();
+        }
+
+        zbar::Image zbar_image(gray.cols, gray.rows, "Y800", gray.data, static_cast<unsigned long>(gray.total()));
+        zbar::ImageScanner& polarity_scanner = request.is_inverted ? inverted_scanner : scanner;
+        int n;
+        {
+            ScopedStageTimer zbar_timer(request.instrumentation, SCAN_STAGE_ZBAR);
+            n = polarity_scanner.scan(zbar_image);
+        }
+        if (n <= 0) return;
+
+        for (auto symbol = zbar_image.symbol_begin(); symbol != zbar_image.symbol_end(); ++symbol) {
+            SymbologyType symbology = convertZBarType(symbol->get_type());
+            // ZBar can still report a related type, e.g. UPC-A as EAN-13
+            if (!(request.symbologies & symbologyBit(symbology))) continue;
+
+            BarcodeResult result;
+            request.storeText(result, symbol->get_data());
+            result.symbology = symbology;
+            result.symbology_name = getSymbologyName(symbology);
+            result.is_color_inverted = request.is_inverted;
+            result.confidence = 1.0;
+
+            // A thin box along the scanline(s) the code was read on
+            std::vector<cv::Point> points;
+            for (int i = 0; i < symbol->get_location_size(); ++i) {
+                points.push_back(cv::Point(symbol->get_location_x(i), symbol->get_location_y(i)));
+            }
+            result.location = request.toFrame(points.empty() ? cv::Rect(0, 0, gray.cols, gray.rows)
+                                                             : cv::boundingRect(points));
+            results.push_back(std::move(result));
+        }
+    }
+
+private:
+    // Configuration and result mapping both read this table
+    static constexpr std::pair<SymbologyType, zbar::zbar_symbol_type_t> ZBAR_SYMBOLOGIES[] = {
+        {SymbologyType::Code128, zbar::ZBAR_CODE128},
+        {SymbologyType::Code39, zbar::ZBAR_CODE39},
+        {SymbologyType::Code93, zbar::ZBAR_CODE93},
+        {SymbologyType::EAN13, zbar::ZBAR_EAN13},
+        {SymbologyType::EAN8, zbar::ZBAR_EAN8},
+        {SymbologyType::UPCA, zbar::ZBAR_UPCA},
+        {SymbologyType::UPCE, zbar::ZBAR_UPCE},
+    };
+
+    static void configureScanner(zbar::ImageScanner& target, SymbologyMask symbologies) {
+        target.set_config(zbar::ZBAR_NONE, zbar::ZBAR_CFG_ENABLE, 0);
+        for (const auto& entry : ZBAR_SYMBOLOGIES) {
+            if (symbologies & symbologyBit(entry.first)) target.set_config(entry.second, zbar::ZBAR_CFG_ENABLE, 1);
+        }
+    }
+
+    static SymbologyType convertZBarType(zbar::zbar_symbol_type_t type) {
+        for (const auto& entry : ZBAR_SYMBOLOGIES) {
+            if (entry.second == type) return entry.first;
+        }
+        return SymbologyType::None;
+    }
+
+    zbar::ImageScanner scanner;
+    zbar::ImageScanner inverted_scanner;
+};
+#endif
+
+std::unique_ptr<DecoderBackend> createDecoderBackend(DecoderEngine engine) {
+    switch (engine) {
+#if BARCODE_HAVE_ZBAR
+        case ENGINE_ZBAR: return std::unique_ptr<DecoderBackend>(new ZBarBackend());
+#endif
+        case ENGINE_ZXING: return std::unique_ptr<DecoderBackend>(new ZXingBackend());
+        case ENGINE_LIBDMTX: return std::unique_ptr<DecoderBackend>(new LibdmtxBackend());
+        default: return nullptr;
+    }
+}
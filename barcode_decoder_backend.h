@@ -0,0 +1,64 @@
+#ifndef BARCODE_DECODER_BACKEND_H
+#define BARCODE_DECODER_BACKEND_H
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "barcode_scanner_lib.h"
+
+// A code one engine located but could not decode, in the coordinates of the
+// image processImage() was given, for a later engine to retry
+struct DecodeCandidate {
+    SymbologyType symbology;
+    cv::Rect region;
+    bool is_inverted;
+};
+
+// One call into a backend. Everything it points to is owned by the scanner
+// and outlives the call.
+struct DecodeRequest {
+    cv::Mat image;             // Gray, may be a view into a larger plane
+    double to_frame;           // Maps positions in image back to the frame, e.g. for pyramid levels
+    SymbologyMask symbologies; // Only these are reported
+    bool is_inverted;          // image is the inverted copy of the frame
+    int max_codes;             // Codes still wanted from this engine
+    const DecoderPlan* plan;
+    FrameDeadline* deadline;
+    ScanCancellationToken* token;           // Optional, set while an inverted pass runs
+    std::vector<DecodeCandidate>* candidates;  // Optional, added to by locating engines, read by later ones
+    FrameBufferPool* buffers;               // Scratch images, e.g. inverted or contiguous copies
+    std::shared_ptr<BarcodeTextArena> text; // The frame's arena
+    ScanInstrumentation instrumentation;
+
+    // Stores data in the frame's arena and makes result refer to it
+    void storeText(BarcodeResult& result, std::string_view data) const;
+    cv::Rect toFrame(const cv::Rect& rect) const;
+};
+
+// One decoder library behind the scanner. The scanner calls configure() on
+// its own thread whenever the plan changes, and decode() from the normal and
+// the inverted pass at once, and from several pyramid levels at once for
+// ZXing; backends keep any per-polarity state apart (ZBar has one scanner
+// for each).
+class DecoderBackend {
+public:
+    virtual ~DecoderBackend() = default;
+
+    virtual DecoderEngine engine() const = 0;
+    // Called before the first frame of every plan generation
+    virtual void configure(const DecoderPlan& plan) { (void)plan; }
+    // Appends what it decoded, in frame coordinates (see to_frame)
+    virtual void decode(const DecodeRequest& request, std::vector<BarcodeResult>& results) = 0;
+};
+
+// ZXing formats that read symbologies; symbologies without a ZXing format
+// add none
+ZXing::BarcodeFormats getZXingFormats(SymbologyMask symbologies);
+
+// Built-in backend for engine, null when it was not compiled in
+std::unique_ptr<DecoderBackend> createDecoderBackend(DecoderEngine engine);
+
+#endif // BARCODE_DECODER_BACKEND_H
@@ -0,0 +1,180 @@
+#include "barcode_image_writer.h"
+
+#include <exception>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+#include "barcode_logger.h"
+
+ImageWriterOptions defaultImageWriterOptions() {
+    ImageWriterOptions options;
+    options.format = IMAGE_FORMAT_JPEG;
+    options.jpeg_quality = 90;
+    options.png_compression = 1;
+    options.max_pending = 8;
+    return options;
+}
+
+const char* getImageFormatExtension(ImageFileFormat format) {
+    switch (format) {
+        case IMAGE_FORMAT_PNG: return ".png";
+        case IMAGE_FORMAT_RAW: return ".ppm";
+        case IMAGE_FORMAT_JPEG:
+        default: return ".jpg";
+    }
+}
+
+bool parseImageFileFormat(const std::string& name, ImageFileFormat& format) {
+    if (name == "jpeg" || name == "jpg") {
+        format = IMAGE_FORMAT_JPEG;
+    } else if (name == "png") {
+        format = IMAGE_FORMAT_PNG;
+    } else if (name == "raw") {
+        format = IMAGE_FORMAT_RAW;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Encoding must never compete with the decode threads
+static void lowerCurrentThreadPriority() {
+#if defined(__linux__)
+    // Linux applies nice values per thread
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#elif defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#endif
+}
+
+AsyncImageWriter::AsyncImageWriter(const ImageWriterOptions& writer_options)
+    : options(writer_options), jobs(writer_options.max_pending),
+      pending(0), written(0), failed(0), dropped(0), stopping(false) {
+    writer = std::thread(&AsyncImageWriter::writerLoop, this);
+}
+
+AsyncImageWriter::~AsyncImageWriter() {
+    flush();
+    stopping = true;
+    wake_writer.notify_all();
+    writer.join();
+}
+
+bool AsyncImageWriter::submit(const cv::Mat& image, const std::string& path, OverlayRenderer render) {
+    if (image.empty()) return false;
+
+    Job job;
+    job.image = image;  // Shares the caller's buffer, nothing is copied here
+    job.path = outputPath(path);
+    job.render = std::move(render);
+
+    // Counted before the push so the writer can never finish it first. The
+    // queue rounds its capacity up, so the backlog is bounded here.
+    if (pending.fetch_add(1) >= options.max_pending || !jobs.tryPush(job)) {
+        finishJob();
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        BARCODE_LOG_WARNING("Image writer busy, dropped " << job.path);
+        return false;
+    }
+    wake_writer.notify_one();
+    return true;
+}
+
+void AsyncImageWriter::finishJob() {
+    if (pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        drained.notify_all();
+    }
+}
+
+void AsyncImageWriter::flush() {
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    drained.wait(lock, [this] { return pending.load() == 0; });
+}
+
+std::string AsyncImageWriter::outputPath(const std::string& path) const {
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    std::string stem = (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+                     ? path.substr(0, dot) : path;
+    return stem + getImageFormatExtension(options.format);
+}
+
+size_t AsyncImageWriter::getWrittenCount() const {
+    return written.load();
+}
+
+size_t AsyncImageWriter::getFailedCount() const {
+    return failed.load();
+}
+
+size_t AsyncImageWriter::getDroppedCount() const {
+    return dropped.load();
+}
+
+void AsyncImageWriter::writerLoop() {
+    lowerCurrentThreadPriority();
+
+    for (;;) {
+        Job job;
+        if (jobs.tryPop(job)) {
+            writeJob(job);
+            job = Job();  // Release the frame before reporting completion
+            finishJob();
+            continue;
+        }
+
+        if (stopping) return;
+        // submit() does not take the lock, so do not rely on the notify alone
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake_writer.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+void AsyncImageWriter::writeJob(Job& job) {
+    try {
+        cv::Mat output;
+        if (job.render) {
+            // Overlays are drawn in colour on a private copy
+            if (job.image.channels() == 1) {
+                cv::cvtColor(job.image, output, cv::COLOR_GRAY2BGR);
+            } else {
+                output = job.image.clone();
+            }
+            job.render(output);
+        } else {
+            output = job.image;
+        }
+
+        std::vector<int> params;
+        switch (options.format) {
+            case IMAGE_FORMAT_PNG:
+                params = {cv::IMWRITE_PNG_COMPRESSION, options.png_compression};
+                break;
+            case IMAGE_FORMAT_RAW:
+                params = {cv::IMWRITE_PXM_BINARY, 1};
+                break;
+            case IMAGE_FORMAT_JPEG:
+            default:
+                params = {cv::IMWRITE_JPEG_QUALITY, options.jpeg_quality};
+        }
+
+        if (cv::imwrite(job.path, output, params)) {
+            written.fetch_add(1);
+            BARCODE_LOG_DEBUG("Result image written: " << job.path);
+        } else {
+            failed.fetch_add(1);
+            BARCODE_LOG_ERROR("Failed to write result image: " << job.path);
+        }
+    } catch (const std::exception& e) {
+        failed.fetch_add(1);
+        BARCODE_LOG_ERROR("Failed to write result image " << job.path << ": " << e.what());
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef BARCODE_IMAGE_WRITER_H
+#define BARCODE_IMAGE_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <opencv2/opencv.hpp>
+
+#include "barcode_queue.h"
+
+// On-disk format of result images
+enum ImageFileFormat {
+    IMAGE_FORMAT_JPEG,
+    IMAGE_FORMAT_PNG,
+    IMAGE_FORMAT_RAW  // Binary PPM: a short header and the pixels, no compression
+};
+
+struct ImageWriterOptions {
+    ImageFileFormat format;
+    int jpeg_quality;     // 0-100
+    int png_compression;  // 0-9, low values encode much faster
+    size_t max_pending;   // Further images are dropped rather than queued
+};
+
+ImageWriterOptions defaultImageWriterOptions();
+
+const char* getImageFormatExtension(ImageFileFormat format);
+// Accepts "jpeg"/"jpg", "png" and "raw"
+bool parseImageFileFormat(const std::string& name, ImageFileFormat& format);
+
+// Draws onto a BGR copy of the frame, on the writer thread
+using OverlayRenderer = std::function<void(cv::Mat& image)>;
+
+// Renders and encodes result images on one low-priority background thread
+// so neither the overlay copy nor JPEG/PNG encoding sits on the decode
+// path. The caller only hands over a reference to its frame; the copy the
+// overlay is drawn on is made by the writer.
+class AsyncImageWriter {
+public:
+    explicit AsyncImageWriter(const ImageWriterOptions& options = defaultImageWriterOptions());
+    // Writes whatever is still queued
+    ~AsyncImageWriter();
+
+    AsyncImageWriter(const AsyncImageWriter&) = delete;
+    AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+
+    // Queues image for writing to path, with the extension replaced by the
+    // format's. image shares its buffer with the caller, which must not
+    // write into it until flush(). Returns false and drops the image when
+    // max_pending images are already waiting.
+    bool submit(const cv::Mat& image, const std::string& path, OverlayRenderer render = OverlayRenderer());
+
+    // Waits until every submitted image was written
+    void flush();
+
+    // path with its extension replaced by the configured format's
+    std::string outputPath(const std::string& path) const;
+
+    size_t getWrittenCount() const;
+    size_t getFailedCount() const;
+    size_t getDroppedCount() const;
+
+private:
+    struct Job {
+        cv::Mat image;
+        std::string path;
+        OverlayRenderer render;
+    };
+
+    void writerLoop();
+    void writeJob(Job& job);
+    void finishJob();
+
+    ImageWriterOptions options;
+    BoundedQueue<Job> jobs;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake_writer;
+    std::condition_variable drained;
+    std::atomic<size_t> pending;  // Submitted and not yet written
+    std::atomic<size_t> written;
+    std::atomic<size_t> failed;
+    std::atomic<size_t> dropped;
+    std::atomic<bool> stopping;
+    std::thread writer;
+};
+
+#endif // BARCODE_IMAGE_WRITER_H
@@ -0,0 +1,95 @@
+#include "barcode_localizer.h"
+
+#include <algorithm>
+
+BarcodeLocalizerOptions defaultLocalizerOptions() {
+    BarcodeLocalizerOptions options;
+    options.work_width = 640;
+    options.min_region_side = 12;
+    options.max_regions = 8;
+    options.padding = 0.15;
+    return options;
+}
+
+BarcodeLocalizer::BarcodeLocalizer(const BarcodeLocalizerOptions& opts)
+    : options(opts) {
+}
+
+// Overlapping candidates are usually parts of one label, decode them once
+static void mergeOverlappingRegions(std::vector<cv::Rect>& regions) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < regions.size() && !merged; ++i) {
+            for (size_t j = i + 1; j < regions.size(); ++j) {
+                if ((regions[i] & regions[j]).area() > 0) {
+                    regions[i] |= regions[j];
+                    regions.erase(regions.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+std::vector<cv::Rect> BarcodeLocalizer::locate(const cv::Mat& gray) {
+    std::vector<cv::Rect> regions;
+    if (gray.empty()) return regions;
+
+    // A 12MP label shrinks about 6x, which still leaves several pixels per bar
+    // small only ever holds its own pixels; a smaller frame is analysed
+    // through a local header, so no reference to it outlives this call
+    double scale = 1.0;
+    cv::Mat work = gray;
+    if (gray.cols > options.work_width) {
+        scale = static_cast<double>(options.work_width) / gray.cols;
+        cv::resize(gray, small, cv::Size(), scale, scale, cv::INTER_AREA);
+        work = small;
+    }
+
+    // Gradient energy in both directions covers 1D bars at any angle and 2D modules
+    cv::Sobel(work, grad_x, CV_16S, 1, 0, 3);
+    cv::Sobel(work, grad_y, CV_16S, 0, 1, 3);
+    cv::convertScaleAbs(grad_x, abs_x);
+    cv::convertScaleAbs(grad_y, abs_y);
+    cv::add(abs_x, abs_y, energy);
+    cv::blur(energy, energy, cv::Size(7, 7));
+    cv::threshold(energy, mask, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+
+    // Close the gaps between bars, then drop isolated specks
+    cv::Mat close_kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(15, 15));
+    cv::morphologyEx(mask, mask, cv::MORPH_CLOSE, close_kernel);
+    cv::erode(mask, mask, cv::Mat(), cv::Point(-1, -1), 2);
+    cv::dilate(mask, mask, cv::Mat(), cv::Point(-1, -1), 2);
+
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+    for (const auto& contour : contours) {
+        cv::Rect box = cv::boundingRect(contour);
+        if (std::min(box.width, box.height) < options.min_region_side) continue;
+        regions.push_back(box);
+    }
+
+    std::sort(regions.begin(), regions.end(), [](const cv::Rect& a, const cv::Rect& b) {
+        return a.area() > b.area();
+    });
+    if (static_cast<int>(regions.size()) > options.max_regions) {
+        regions.resize(options.max_regions);
+    }
+
+    // Back to frame coordinates with room for the quiet zone
+    const cv::Rect frame(0, 0, gray.cols, gray.rows);
+    for (auto& box : regions) {
+        int pad_x = static_cast<int>(box.width * options.padding) + 2;
+        int pad_y = static_cast<int>(box.height * options.padding) + 2;
+        box = cv::Rect(static_cast<int>((box.x - pad_x) / scale),
+                       static_cast<int>((box.y - pad_y) / scale),
+                       static_cast<int>((box.width + 2 * pad_x) / scale),
+                       static_cast<int>((box.height + 2 * pad_y) / scale)) & frame;
+    }
+
+    mergeOverlappingRegions(regions);
+    return regions;
+}
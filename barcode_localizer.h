@@ -0,0 +1,36 @@
+#ifndef BARCODE_LOCALIZER_H
+#define BARCODE_LOCALIZER_H
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// Tuning for the localisation front end
+struct BarcodeLocalizerOptions {
+    int work_width;        // Frames are downsampled to this width before analysis
+    int min_region_side;   // Smallest candidate side kept, in work-image pixels
+    int max_regions;       // Largest candidates first, the rest are dropped
+    double padding;        // Fraction of the candidate size added on every side
+};
+
+BarcodeLocalizerOptions defaultLocalizerOptions();
+
+// Finds the areas of a grayscale frame that are worth handing to the full
+// decoders. Bars and modules give strong, dense gradients, so the frame is
+// downsampled, its gradient energy smoothed and thresholded, and nearby
+// blobs merged with a morphological close. Candidates come back padded and
+// clipped to the frame, in frame coordinates.
+//
+// Keeps its scratch buffers between calls; use one localizer per thread.
+class BarcodeLocalizer {
+public:
+    explicit BarcodeLocalizer(const BarcodeLocalizerOptions& options = defaultLocalizerOptions());
+
+    std::vector<cv::Rect> locate(const cv::Mat& gray);
+
+private:
+    BarcodeLocalizerOptions options;
+    cv::Mat small, grad_x, grad_y, abs_x, abs_y, energy, mask;
+};
+
+#endif // BARCODE_LOCALIZER_H
@@ -0,0 +1,246 @@
+#include "barcode_logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// Bounded multi-producer ring with one sequence number per slot: producers
+// claim a slot with a single compare-exchange and never wait on each other
+// or on the writer thread.
+class LogRingBuffer {
+public:
+    static const size_t CAPACITY = 1024;   // Power of two
+    static const size_t MESSAGE_SIZE = 256; // Longer messages are truncated
+
+    LogRingBuffer() : enqueue_pos(0), dequeue_pos(0) {
+        for (size_t i = 0; i < CAPACITY; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(LogLevel level, const std::string& message) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[pos & (CAPACITY - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->level = level;
+        slot->length = std::min(message.size(), MESSAGE_SIZE);
+        std::memcpy(slot->text, message.data(), slot->length);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Single consumer
+    template <typename Consumer>
+    bool pop(Consumer&& consume) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Slot& slot = slots[pos & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+
+        consume(slot.level, slot.text, slot.length);
+        slot.sequence.store(pos + CAPACITY, std::memory_order_release);
+        dequeue_pos.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Safe from any thread; a message counts as gone once its sink write returned
+    bool empty() const {
+        size_t pos = dequeue_pos.load(std::memory_order_acquire);
+        const Slot& slot = slots[pos & (CAPACITY - 1)];
+        return slot.sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        size_t length;
+        char text[MESSAGE_SIZE];
+    };
+
+    Slot slots[CAPACITY];
+    alignas(64) std::atomic<size_t> enqueue_pos;
+    alignas(64) std::atomic<size_t> dequeue_pos;  // Only advanced by the writer, or by setAsync(false) after it
+};
+
+struct BarcodeLogger::Impl {
+    std::shared_ptr<LogSink> sink;
+    LogRingBuffer ring;
+    std::atomic<bool> async;
+    std::atomic<int> pushing;  // Producers that saw async on and may still push
+    std::atomic<size_t> dropped;
+
+    std::mutex writer_mutex;  // Guards the writer thread and the sink in sync mode
+    std::condition_variable wake_writer;
+    std::condition_variable drained;
+    std::thread writer;
+    bool stopping;
+
+    Impl() : sink(std::make_shared<ConsoleLogSink>()), async(false), pushing(0), dropped(0), stopping(false) {}
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(writer_mutex);
+        for (;;) {
+            // Producers do not notify, so poll with a short timeout
+            wake_writer.wait_for(lock, std::chrono::milliseconds(10));
+
+            std::shared_ptr<LogSink> current = std::atomic_load(&sink);
+            lock.unlock();
+            while (ring.pop([&](LogLevel level, const char* text, size_t length) {
+                current->write(level, text, length);
+            })) {
+            }
+            current->flush();
+            lock.lock();
+
+            drained.notify_all();
+            if (stopping && ring.empty()) return;
+        }
+    }
+
+    // Writes what is left in the ring once the writer has stopped; the
+    // caller holds writer_mutex
+    void drainRemaining() {
+        std::shared_ptr<LogSink> current = std::atomic_load(&sink);
+        while (ring.pop([&](LogLevel level, const char* text, size_t length) {
+            current->write(level, text, length);
+        })) {
+        }
+        current->flush();
+    }
+};
+
+ConsoleLogSink::ConsoleLogSink(std::ostream& output) : stream(output) {
+}
+
+void ConsoleLogSink::write(LogLevel level, const char* message, size_t length) {
+    (void)level;
+    stream.write(message, static_cast<std::streamsize>(length));
+    stream.put('\n');
+}
+
+void ConsoleLogSink::flush() {
+    stream.flush();
+}
+
+const char* getLogLevelName(LogLevel level) {
+    switch (level) {
+        case LOG_LEVEL_TRACE: return "TRACE";
+        case LOG_LEVEL_DEBUG: return "DEBUG";
+        case LOG_LEVEL_INFO: return "INFO";
+        case LOG_LEVEL_WARNING: return "WARNING";
+        case LOG_LEVEL_ERROR: return "ERROR";
+        default: return "OFF";
+    }
+}
+
+BarcodeLogger& BarcodeLogger::instance() {
+    static BarcodeLogger logger;
+    return logger;
+}
+
+BarcodeLogger::BarcodeLogger() : impl(new Impl()), level(LOG_LEVEL_INFO) {
+}
+
+BarcodeLogger::~BarcodeLogger() {
+    setAsync(false);
+}
+
+void BarcodeLogger::setLevel(LogLevel new_level) {
+    level.store(new_level, std::memory_order_relaxed);
+}
+
+LogLevel BarcodeLogger::getLevel() const {
+    return static_cast<LogLevel>(level.load(std::memory_order_relaxed));
+}
+
+bool BarcodeLogger::isEnabled(LogLevel message_level) const {
+    return message_level >= level.load(std::memory_order_relaxed);
+}
+
+void BarcodeLogger::setSink(std::shared_ptr<LogSink> sink) {
+    if (!sink) sink = std::make_shared<ConsoleLogSink>();
+    std::atomic_store(&impl->sink, sink);
+}
+
+std::shared_ptr<LogSink> BarcodeLogger::getSink() const {
+    return std::atomic_load(&impl->sink);
+}
+
+void BarcodeLogger::setAsync(bool async) {
+    std::unique_lock<std::mutex> lock(impl->writer_mutex);
+    if (async == impl->writer.joinable()) return;
+    // Another call is already stopping the writer
+    if (!async && impl->stopping) return;
+
+    if (async) {
+        impl->stopping = false;
+        impl->writer = std::thread(&Impl::writerLoop, impl.get());
+        impl->async = true;
+    } else {
+        // Producers keep queueing until the writer is gone, so nothing reaches
+        // the sink from two threads at once
+        impl->stopping = true;
+        impl->wake_writer.notify_all();
+        lock.unlock();
+        impl->writer.join();
+
+        // Messages queued after the writer's last pass are written here, and
+        // sync writers wait on the lock until they are
+        lock.lock();
+        impl->async = false;
+        while (impl->pushing.load() > 0) std::this_thread::yield();
+        impl->drainRemaining();
+    }
+}
+
+bool BarcodeLogger::isAsync() const {
+    return impl->async.load(std::memory_order_relaxed);
+}
+
+void BarcodeLogger::write(LogLevel message_level, const std::string& message) {
+    impl->pushing.fetch_add(1);
+    if (impl->async.load()) {
+        if (!impl->ring.push(message_level, message)) {
+            impl->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        impl->pushing.fetch_sub(1);
+        return;
+    }
+    impl->pushing.fetch_sub(1);
+
+    // Sync mode serialises writers so lines do not interleave
+    std::shared_ptr<LogSink> sink = std::atomic_load(&impl->sink);
+    std::lock_guard<std::mutex> lock(impl->writer_mutex);
+    sink->write(message_level, message.data(), message.size());
+}
+
+void BarcodeLogger::flush() {
+    std::unique_lock<std::mutex> lock(impl->writer_mutex);
+    if (impl->writer.joinable()) {
+        impl->wake_writer.notify_all();
+        impl->drained.wait(lock, [this] { return impl->ring.empty(); });
+        return;
+    }
+    std::atomic_load(&impl->sink)->flush();
+}
+
+size_t BarcodeLogger::getDroppedCount() const {
+    return impl->dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,106 @@
+#ifndef BARCODE_LOGGER_H
+#define BARCODE_LOGGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+enum LogLevel {
+    LOG_LEVEL_TRACE = 0,   // Per barcode / per engine detail
+    LOG_LEVEL_DEBUG = 1,   // Per frame
+    LOG_LEVEL_INFO = 2,    // Setup and configuration
+    LOG_LEVEL_WARNING = 3,
+    LOG_LEVEL_ERROR = 4,
+    LOG_LEVEL_OFF = 5
+};
+
+// Messages below this level are compiled out entirely. The default keeps
+// per-frame and per-barcode messages out of production builds; pass
+// -DBARCODE_LOG_COMPILE_LEVEL=0 to get them back.
+#ifndef BARCODE_LOG_COMPILE_LEVEL
+#define BARCODE_LOG_COMPILE_LEVEL 2
+#endif
+
+// Destination for formatted messages. Called from the logging thread when
+// async logging is on, otherwise from the thread that logged.
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+    virtual void write(LogLevel level, const char* message, size_t length) = 0;
+    virtual void flush() {}
+};
+
+// Writes one line per message to stdout (or another stream, e.g. std::cerr
+// when stdout carries data) without forcing a flush
+class ConsoleLogSink : public LogSink {
+public:
+    explicit ConsoleLogSink(std::ostream& stream = std::cout);
+    void write(LogLevel level, const char* message, size_t length) override;
+    void flush() override;
+
+private:
+    std::ostream& stream;
+};
+
+const char* getLogLevelName(LogLevel level);
+
+// Process-wide logger. With async logging on, callers only format into a
+// fixed-size slot of a lock-free ring buffer and a background thread hands
+// the messages to the sink; when the ring is full the message is dropped
+// and counted instead of blocking the decode path.
+class BarcodeLogger {
+public:
+    static BarcodeLogger& instance();
+
+    BarcodeLogger(const BarcodeLogger&) = delete;
+    BarcodeLogger& operator=(const BarcodeLogger&) = delete;
+
+    void setLevel(LogLevel level);
+    LogLevel getLevel() const;
+    bool isEnabled(LogLevel level) const;
+
+    void setSink(std::shared_ptr<LogSink> sink);
+    std::shared_ptr<LogSink> getSink() const;
+
+    // Starts or stops the background writer; stopping drains the ring first
+    void setAsync(bool async);
+    bool isAsync() const;
+
+    void write(LogLevel level, const std::string& message);
+
+    // Waits until queued messages reached the sink, then flushes it
+    void flush();
+
+    // Messages lost because the ring was full
+    size_t getDroppedCount() const;
+
+private:
+    BarcodeLogger();
+    ~BarcodeLogger();
+
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+    std::atomic<int> level;
+};
+
+// The stream expression is only evaluated when the level is enabled
+#define BARCODE_LOG(level, message)                                               \
+    do {                                                                          \
+        if ((level) >= BARCODE_LOG_COMPILE_LEVEL &&                               \
+            BarcodeLogger::instance().isEnabled(level)) {                         \
+            std::ostringstream barcode_log_stream;                                \
+            barcode_log_stream << message;                                        \
+            BarcodeLogger::instance().write(level, barcode_log_stream.str());     \
+        }                                                                         \
+    } while (0)
+
+#define BARCODE_LOG_TRACE(message) BARCODE_LOG(LOG_LEVEL_TRACE, message)
+#define BARCODE_LOG_DEBUG(message) BARCODE_LOG(LOG_LEVEL_DEBUG, message)
+#define BARCODE_LOG_INFO(message) BARCODE_LOG(LOG_LEVEL_INFO, message)
+#define BARCODE_LOG_WARNING(message) BARCODE_LOG(LOG_LEVEL_WARNING, message)
+#define BARCODE_LOG_ERROR(message) BARCODE_LOG(LOG_LEVEL_ERROR, message)
+
+#endif // BARCODE_LOGGER_H
@@ -0,0 +1,264 @@
+#include "barcode_luma.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BARCODE_LUMA_AVX2 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define BARCODE_LUMA_NEON 1
+#include <arm_neon.h>
+#endif
+
+// cv::cvtColor's fixed-point BT.601 weights, so the result is bit-exact
+static constexpr int LUMA_SHIFT = 14;
+static constexpr int B_WEIGHT = 1868;
+static constexpr int G_WEIGHT = 9617;
+static constexpr int R_WEIGHT = 4899;
+
+// Scalar kernels, also used for the row tails of the vector ones. Each
+// starts at column x and leaves x at the row width.
+
+static void colorRowToLumaScalar(const uint8_t* src, int channels, uint8_t* dst, int width, int& x) {
+    for (; x < width; ++x) {
+        const uint8_t* pixel = src + x * channels;
+        dst[x] = static_cast<uint8_t>((pixel[0] * B_WEIGHT + pixel[1] * G_WEIGHT + pixel[2] * R_WEIGHT +
+                                       (1 << (LUMA_SHIFT - 1))) >> LUMA_SHIFT);
+    }
+}
+
+static void invertRowScalar(const uint8_t* src, uint8_t* dst, int width, int& x) {
+    for (; x < width; ++x) dst[x] = static_cast<uint8_t>(255 - src[x]);
+}
+
+static void halveRowScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int half_width, int& x) {
+    for (; x < half_width; ++x) {
+        dst[x] = static_cast<uint8_t>((row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1] + 2) >> 2);
+    }
+}
+
+#if BARCODE_LUMA_AVX2
+
+static bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+// Eight BGRX pixels (one per 32-bit lane) to eight 32-bit luma values.
+// The (B, R) and (G, X) byte pairs are multiplied and summed with one
+// madd each.
+__attribute__((target("avx2")))
+static inline __m256i weighBgrx(__m256i pixels) {
+    const __m256i low_bytes = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i br_weights = _mm256_set1_epi32(B_WEIGHT | (R_WEIGHT << 16));
+    const __m256i g_weights = _mm256_set1_epi32(G_WEIGHT);
+    const __m256i rounding = _mm256_set1_epi32(1 << (LUMA_SHIFT - 1));
+
+    __m256i br = _mm256_and_si256(pixels, low_bytes);
+    __m256i gx = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), low_bytes);
+    __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(br, br_weights), _mm256_madd_epi16(gx, g_weights));
+    return _mm256_srli_epi32(_mm256_add_epi32(sum, rounding), LUMA_SHIFT);
+}
+
+// Two groups of eight 32-bit luma values to sixteen bytes in order
+__attribute__((target("avx2")))
+static inline void storeLuma16(uint8_t* dst, __m256i first, __m256i second) {
+    __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), bytes);
+}
+
+__attribute__((target("avx2")))
+static void bgrRowToLumaAvx2(const uint8_t* src, uint8_t* dst, int width, int& x) {
+    // Spreads 24 bytes (8 pixels) over the two 128-bit lanes, 12 bytes each,
+    // then pads every pixel to 32 bits
+    const __m256i spread = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+    const __m256i to_bgrx = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                             0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+    // Each 32-byte load reads 8 bytes past its pixels, keep it inside the row
+    for (; x + 19 <= width; x += 16) {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 3));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (x + 8) * 3));
+        first = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(first, spread), to_bgrx);
+        second = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(second, spread), to_bgrx);
+        storeLuma16(dst + x, weighBgrx(first), weighBgrx(second));
+    }
+}
+
+__attribute__((target("avx2")))
+static void bgraRowToLumaAvx2(const uint8_t* src, uint8_t* dst, int width, int& x) {
+    // Alpha sits in the X byte, which weighBgrx() gives a zero weight
+    for (; x + 16 <= width; x += 16) {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (x + 8) * 4));
+        storeLuma16(dst + x, weighBgrx(first), weighBgrx(second));
+    }
+}
+
+__attribute__((target("avx2")))
+static void invertRowAvx2(const uint8_t* src, uint8_t* dst, int width, int& x) {
+    const __m256i ones = _mm256_set1_epi8(-1);
+    for (; x + 32 <= width; x += 32) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_xor_si256(pixels, ones));
+    }
+}
+
+__attribute__((target("avx2")))
+static void halveRowAvx2(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int half_width, int& x) {
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i rounding = _mm256_set1_epi16(2);
+    for (; x + 16 <= half_width; x += 16) {
+        // Horizontal pairs summed into 16-bit lanes, then the two rows added
+        __m256i top = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 2 * x)), ones);
+        __m256i bottom = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 2 * x)), ones);
+        __m256i mean = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(top, bottom), rounding), 2);
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(mean), _mm256_extracti128_si256(mean, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), bytes);
+    }
+}
+
+#elif BARCODE_LUMA_NEON
+
+static inline uint16x4_t weighNeon(uint16x4_t b, uint16x4_t g, uint16x4_t r) {
+    uint32x4_t sum = vmull_n_u16(b, B_WEIGHT);
+    sum = vmlal_n_u16(sum, g, G_WEIGHT);
+    sum = vmlal_n_u16(sum, r, R_WEIGHT);
+    return vrshrn_n_u32(sum, LUMA_SHIFT);  // Rounds like the scalar kernel
+}
+
+static inline uint8x8_t weighNeon8(uint8x8_t b, uint8x8_t g, uint8x8_t r) {
+    uint16x8_t b16 = vmovl_u8(b), g16 = vmovl_u8(g), r16 = vmovl_u8(r);
+    uint16x4_t low = weighNeon(vget_low_u16(b16), vget_low_u16(g16), vget_low_u16(r16));
+    uint16x4_t high = weighNeon(vget_high_u16(b16), vget_high_u16(g16), vget_high_u16(r16));
+    return vqmovn_u16(vcombine_u16(low, high));
+}
+
+static void colorRowToLumaNeon(const uint8_t* src, int channels, uint8_t* dst, int width, int& x) {
+    for (; x + 16 <= width; x += 16) {
+        uint8x16_t b, g, r;
+        if (channels == 3) {
+            uint8x16x3_t pixels = vld3q_u8(src + x * 3);
+            b = pixels.val[0]; g = pixels.val[1]; r = pixels.val[2];
+        } else {
+            uint8x16x4_t pixels = vld4q_u8(src + x * 4);
+            b = pixels.val[0]; g = pixels.val[1]; r = pixels.val[2];
+        }
+        uint8x8_t low = weighNeon8(vget_low_u8(b), vget_low_u8(g), vget_low_u8(r));
+        uint8x8_t high = weighNeon8(vget_high_u8(b), vget_high_u8(g), vget_high_u8(r));
+        vst1q_u8(dst + x, vcombine_u8(low, high));
+    }
+}
+
+static void invertRowNeon(const uint8_t* src, uint8_t* dst, int width, int& x) {
+    for (; x + 16 <= width; x += 16) {
+        vst1q_u8(dst + x, vmvnq_u8(vld1q_u8(src + x)));
+    }
+}
+
+static void halveRowNeon(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int half_width, int& x) {
+    for (; x + 8 <= half_width; x += 8) {
+        uint16x8_t sum = vaddq_u16(vpaddlq_u8(vld1q_u8(row0 + 2 * x)), vpaddlq_u8(vld1q_u8(row1 + 2 * x)));
+        vst1_u8(dst + x, vrshrn_n_u16(sum, 2));
+    }
+}
+
+#endif
+
+static void colorRowToLuma(const uint8_t* src, int channels, uint8_t* dst, int width) {
+    int x = 0;
+    if (channels == 2) {
+        // YUYV: luma is every second byte
+        for (; x < width; ++x) dst[x] = src[2 * x];
+        return;
+    }
+#if BARCODE_LUMA_AVX2
+    if (hasAvx2()) {
+        if (channels == 3) bgrRowToLumaAvx2(src, dst, width, x);
+        else bgraRowToLumaAvx2(src, dst, width, x);
+    }
+#elif BARCODE_LUMA_NEON
+    colorRowToLumaNeon(src, channels, dst, width, x);
+#endif
+    colorRowToLumaScalar(src, channels, dst, width, x);
+}
+
+static void invertRow(const uint8_t* src, uint8_t* dst, int width) {
+    int x = 0;
+#if BARCODE_LUMA_AVX2
+    if (hasAvx2()) invertRowAvx2(src, dst, width, x);
+#elif BARCODE_LUMA_NEON
+    invertRowNeon(src, dst, width, x);
+#endif
+    invertRowScalar(src, dst, width, x);
+}
+
+static void halveRow(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, int half_width) {
+    int x = 0;
+#if BARCODE_LUMA_AVX2
+    if (hasAvx2()) halveRowAvx2(row0, row1, dst, half_width, x);
+#elif BARCODE_LUMA_NEON
+    halveRowNeon(row0, row1, dst, half_width, x);
+#endif
+    halveRowScalar(row0, row1, dst, half_width, x);
+}
+
+size_t getLumaPlaneBytes(const LumaPlanes& planes) {
+    return planes.luma_buffer.total() + planes.inverted_buffer.total() + planes.half_buffer.total();
+}
+
+const char* getLumaKernelName() {
+#if BARCODE_LUMA_AVX2
+    return hasAvx2() ? "avx2" : "scalar";
+#elif BARCODE_LUMA_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void extractLumaPlanes(const cv::Mat& source, int flags, LumaPlanes& planes) {
+    int channels = source.channels();
+    if (source.depth() != CV_8U || channels < 1 || channels > 4) {
+        throw std::runtime_error("Luma extraction needs an 8-bit image with 1 to 4 channels");
+    }
+
+    const int width = source.cols;
+    const int height = source.rows;
+    const bool convert = channels != 1;
+    const bool invert = (flags & LUMA_PLANE_INVERTED) != 0;
+    const bool halve = (flags & LUMA_PLANE_HALF) != 0 && width >= 2 && height >= 2;
+
+    // Mat::create() keeps the buffer when the size is unchanged
+    if (convert) {
+        planes.luma_buffer.create(height, width, CV_8UC1);
+        planes.luma = planes.luma_buffer;
+    } else {
+        planes.luma = source;
+    }
+    planes.inverted = cv::Mat();
+    if (invert) {
+        planes.inverted_buffer.create(height, width, CV_8UC1);
+        planes.inverted = planes.inverted_buffer;
+    }
+    planes.half = cv::Mat();
+    if (halve) {
+        planes.half_buffer.create(height / 2, width / 2, CV_8UC1);
+        planes.half = planes.half_buffer;
+    }
+
+    if (!convert && !invert && !halve) return;
+
+    for (int y = 0; y < height; y += 2) {
+        int rows = y + 1 < height ? 2 : 1;
+        for (int i = 0; i < rows; ++i) {
+            if (convert) colorRowToLuma(source.ptr(y + i), channels, planes.luma.ptr(y + i), width);
+            if (invert) invertRow(planes.luma.ptr(y + i), planes.inverted.ptr(y + i), width);
+        }
+        if (halve && rows == 2 && y / 2 < planes.half.rows) {
+            halveRow(planes.luma.ptr(y), planes.luma.ptr(y + 1), planes.half.ptr(y / 2), planes.half.cols);
+        }
+    }
+}
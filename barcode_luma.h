@@ -0,0 +1,41 @@
+#ifndef BARCODE_LUMA_H
+#define BARCODE_LUMA_H
+
+#include <opencv2/opencv.hpp>
+
+// Planes extractLumaPlanes() produces in addition to luma
+enum LumaPlaneFlags {
+    LUMA_PLANE_INVERTED = 1 << 0,  // 255 - luma, for the inverted decoder passes
+    LUMA_PLANE_HALF = 1 << 1       // 2x2 box-filtered luma, the first pyramid level
+};
+
+// Output of extractLumaPlanes(). luma, inverted and half are empty unless
+// produced for the current frame; the *_buffer members are the storage
+// behind them and are only reallocated when the frame size changes, so keep
+// one LumaPlanes per scanner and pass it back in every frame.
+struct LumaPlanes {
+    cv::Mat luma;      // Shares the source when it already is single-channel
+    cv::Mat inverted;
+    cv::Mat half;      // (cols / 2) x (rows / 2)
+
+    cv::Mat luma_buffer;
+    cv::Mat inverted_buffer;
+    cv::Mat half_buffer;
+};
+
+// Converts an 8-bit GRAY, YUYV (2 channels, luma first), BGR or BGRA frame
+// in one pass over its pixels: each row pair is converted, inverted and
+// downsampled while it is still in cache, instead of cvtColor, bitwise_not
+// and resize each streaming the whole frame. Uses AVX2 (picked at run time)
+// or NEON kernels where available. Luma is bit-exact with cv::cvtColor's
+// BGR2GRAY, and on even-sized frames the half plane is bit-exact with
+// cv::resize's INTER_AREA.
+void extractLumaPlanes(const cv::Mat& source, int flags, LumaPlanes& planes);
+
+// Memory held by the plane buffers
+size_t getLumaPlaneBytes(const LumaPlanes& planes);
+
+// Kernel used on this machine: "avx2", "neon" or "scalar"
+const char* getLumaKernelName();
+
+#endif // BARCODE_LUMA_H
@@ -0,0 +1,183 @@
+#include "barcode_metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+
+const char* getScanStageName(ScanStage stage) {
+    switch (stage) {
+        case SCAN_STAGE_FRAME: return "frame";
+        case SCAN_STAGE_LUMA: return "luma";
+        case SCAN_STAGE_LOCALIZE: return "localize";
+        case SCAN_STAGE_PREPROCESS: return "preprocess";
+        case SCAN_STAGE_DENOISE: return "denoise";
+        case SCAN_STAGE_ZXING: return "zxing";
+        case SCAN_STAGE_LIBDMTX: return "libdmtx";
+        case SCAN_STAGE_ZBAR: return "zbar";
+        case SCAN_STAGE_MERGE: return "merge";
+        default: return "unknown";
+    }
+}
+
+// Bit length of the duration in microseconds
+static int latencyBucketFor(std::chrono::nanoseconds duration) {
+    uint64_t micros = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0)) / 1000;
+    int bucket = 0;
+    while (micros != 0 && bucket < LATENCY_BUCKET_COUNT - 1) {
+        micros >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::chrono::microseconds StageStatistics::percentile(double fraction) const {
+    if (count == 0) return std::chrono::microseconds(0);
+
+    uint64_t wanted = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * count + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKET_COUNT - 1; ++i) {
+        seen += buckets[i];
+        if (seen >= wanted) return std::chrono::microseconds(int64_t(1) << i);
+    }
+    // Overflow bucket, the largest call is the best bound there is
+    return std::chrono::duration_cast<std::chrono::microseconds>(max);
+}
+
+ScanMetrics::ScanMetrics() {
+    reset();
+}
+
+ScanMetrics::Shard& ScanMetrics::currentShard() {
+    // Threads are dealt shards round-robin the first time they record
+    static std::atomic<unsigned> next_shard(0);
+    thread_local unsigned shard = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+    return shards[shard];
+}
+
+void ScanMetrics::record(ScanStage stage, std::chrono::nanoseconds duration) {
+    Shard& shard = currentShard();
+    uint64_t nanos = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+
+    shard.buckets[stage][latencyBucketFor(duration)].fetch_add(1, std::memory_order_relaxed);
+    shard.total_ns[stage].fetch_add(nanos, std::memory_order_relaxed);
+    // Only this thread writes the shard's max unless threads share a shard
+    uint64_t max = shard.max_ns[stage].load(std::memory_order_relaxed);
+    while (nanos > max && !shard.max_ns[stage].compare_exchange_weak(max, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+void ScanMetrics::recordFrame(size_t codes, bool budget_exhausted) {
+    Shard& shard = currentShard();
+    shard.frames.fetch_add(1, std::memory_order_relaxed);
+    shard.codes.fetch_add(codes, std::memory_order_relaxed);
+    if (budget_exhausted) shard.budget_exhausted_frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+ScanStatistics ScanMetrics::getStatistics() const {
+    ScanStatistics statistics = {};
+    for (const Shard& shard : shards) {
+        statistics.frames += shard.frames.load(std::memory_order_relaxed);
+        statistics.codes += shard.codes.load(std::memory_order_relaxed);
+        statistics.budget_exhausted_frames += shard.budget_exhausted_frames.load(std::memory_order_relaxed);
+
+        for (int stage = 0; stage < SCAN_STAGE_COUNT; ++stage) {
+            StageStatistics& stats = statistics.stages[stage];
+            for (int i = 0; i < LATENCY_BUCKET_COUNT; ++i) {
+                uint64_t calls = shard.buckets[stage][i].load(std::memory_order_relaxed);
+                stats.buckets[i] += calls;
+                stats.count += calls;
+            }
+            stats.total += std::chrono::nanoseconds(shard.total_ns[stage].load(std::memory_order_relaxed));
+            stats.max = std::max(stats.max, std::chrono::nanoseconds(shard.max_ns[stage].load(std::memory_order_relaxed)));
+        }
+    }
+    return statistics;
+}
+
+void ScanMetrics::reset() {
+    for (Shard& shard : shards) {
+        for (int stage = 0; stage < SCAN_STAGE_COUNT; ++stage) {
+            for (auto& bucket : shard.buckets[stage]) bucket.store(0, std::memory_order_relaxed);
+            shard.total_ns[stage].store(0, std::memory_order_relaxed);
+            shard.max_ns[stage].store(0, std::memory_order_relaxed);
+        }
+        shard.frames.store(0, std::memory_order_relaxed);
+        shard.codes.store(0, std::memory_order_relaxed);
+        shard.budget_exhausted_frames.store(0, std::memory_order_relaxed);
+    }
+}
+
+FrameTracer::FrameTracer() : active(false) {
+    trace.frame_index = 0;
+    trace.codes = 0;
+    trace.budget_exhausted = false;
+}
+
+void FrameTracer::begin(uint64_t frame_index) {
+    trace.frame_index = frame_index;
+    trace.start = std::chrono::steady_clock::now();
+    trace.spans.clear();  // Keeps the capacity of earlier frames
+    active = true;
+}
+
+void FrameTracer::addSpan(ScanStage stage, std::chrono::steady_clock::time_point start,
+                          std::chrono::steady_clock::time_point end) {
+    if (!isActive()) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    trace.spans.push_back({stage, start - trace.start, end - start, std::this_thread::get_id()});
+}
+
+const FrameTrace& FrameTracer::finish(size_t codes, bool budget_exhausted) {
+    active = false;
+    trace.codes = codes;
+    trace.budget_exhausted = budget_exhausted;
+    return trace;
+}
+
+ScopedStageTimer::ScopedStageTimer(const ScanInstrumentation& instr, ScanStage timed_stage)
+    : instrumentation(instr), stage(timed_stage), start(std::chrono::steady_clock::now()) {}
+
+ScopedStageTimer::~ScopedStageTimer() {
+    auto end = std::chrono::steady_clock::now();
+    if (instrumentation.metrics) instrumentation.metrics->record(stage, end - start);
+    if (instrumentation.tracer) instrumentation.tracer->addSpan(stage, start, end);
+}
+
+static std::string formatSeconds(double seconds) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", seconds);
+    return text;
+}
+
+static void appendCounter(std::string& out, const char* name, const char* help, uint64_t value) {
+    out += std::string("# HELP ") + name + " " + help + "\n";
+    out += std::string("# TYPE ") + name + " counter\n";
+    out += std::string(name) + " " + std::to_string(value) + "\n";
+}
+
+std::string formatPrometheusMetrics(const ScanStatistics& statistics) {
+    std::string out;
+    out += "# HELP barcode_scan_stage_seconds Time spent in each scan stage.\n";
+    out += "# TYPE barcode_scan_stage_seconds histogram\n";
+    for (int stage = 0; stage < SCAN_STAGE_COUNT; ++stage) {
+        const StageStatistics& stats = statistics.stages[stage];
+        std::string labels = std::string("{stage=\"") + getScanStageName(static_cast<ScanStage>(stage)) + "\"";
+
+        // Prometheus buckets are cumulative
+        uint64_t cumulative = 0;
+        for (int i = 0; i < LATENCY_BUCKET_COUNT - 1; ++i) {
+            cumulative += stats.buckets[i];
+            out += "barcode_scan_stage_seconds_bucket" + labels + ",le=\"" +
+                   formatSeconds(static_cast<double>(int64_t(1) << i) * 1e-6) + "\"} " + std::to_string(cumulative) + "\n";
+        }
+        out += "barcode_scan_stage_seconds_bucket" + labels + ",le=\"+Inf\"} " + std::to_string(stats.count) + "\n";
+        out += "barcode_scan_stage_seconds_sum" + labels + "} " +
+               formatSeconds(std::chrono::duration<double>(stats.total).count()) + "\n";
+        out += "barcode_scan_stage_seconds_count" + labels + "} " + std::to_string(stats.count) + "\n";
+    }
+
+    appendCounter(out, "barcode_scan_frames_total", "Frames scanned.", statistics.frames);
+    appendCounter(out, "barcode_scan_codes_total", "Codes reported.", statistics.codes);
+    appendCounter(out, "barcode_scan_budget_exhausted_frames_total", "Frames cut short by their time budget.",
+                  statistics.budget_exhausted_frames);
+    return out;
+}
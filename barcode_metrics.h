@@ -0,0 +1,150 @@
+#ifndef BARCODE_METRICS_H
+#define BARCODE_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Timed parts of a scan. Stages nest (denoise is part of preprocess, every
+// stage is part of frame) and the concurrent passes overlap, so stage times
+// do not add up to the frame time.
+enum ScanStage {
+    SCAN_STAGE_FRAME,       // processFrame() as a whole
+    SCAN_STAGE_LUMA,        // Luma and inverted plane extraction
+    SCAN_STAGE_LOCALIZE,    // Gradient-energy candidate search
+    SCAN_STAGE_PREPROCESS,  // The low-resolution enhancement chain
+    SCAN_STAGE_DENOISE,     // The chain's denoise filter; frames that skip it record nothing
+    SCAN_STAGE_ZXING,       // One ReadBarcodes() call
+    SCAN_STAGE_LIBDMTX,     // One libdmtx search of an image or region
+    SCAN_STAGE_ZBAR,        // One ZBar scan
+    SCAN_STAGE_MERGE,       // Duplicate merge of the frame's results
+    SCAN_STAGE_COUNT
+};
+
+// Lower-case name, used as the Prometheus stage label
+const char* getScanStageName(ScanStage stage);
+
+// Bucket i counts durations below 2^i microseconds that did not fit bucket
+// i - 1; the last bucket takes everything from about 67 s up
+static const int LATENCY_BUCKET_COUNT = 28;
+
+struct StageStatistics {
+    uint64_t count;
+    std::chrono::nanoseconds total;
+    std::chrono::nanoseconds max;
+    uint64_t buckets[LATENCY_BUCKET_COUNT];
+
+    // Upper bound of the bucket holding the given fraction of the calls,
+    // e.g. 0.99 for p99; zero without calls
+    std::chrono::microseconds percentile(double fraction) const;
+};
+
+struct ScanStatistics {
+    uint64_t frames;
+    uint64_t codes;
+    uint64_t budget_exhausted_frames;
+    StageStatistics stages[SCAN_STAGE_COUNT];
+};
+
+// Histograms and counters for every stage. Each thread records into its own
+// cache-line aligned shard with relaxed atomics, so the decode path never
+// takes a lock or contends with other threads; getStatistics() sums the
+// shards. One instance can be shared by several scanners (e.g. a pool).
+class ScanMetrics {
+public:
+    ScanMetrics();
+    ScanMetrics(const ScanMetrics&) = delete;
+    ScanMetrics& operator=(const ScanMetrics&) = delete;
+
+    void record(ScanStage stage, std::chrono::nanoseconds duration);
+    void recordFrame(size_t codes, bool budget_exhausted);
+
+    // Consistent per counter, not across counters taken while frames run
+    ScanStatistics getStatistics() const;
+    void reset();
+
+private:
+    static const int SHARD_COUNT = 16;
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> buckets[SCAN_STAGE_COUNT][LATENCY_BUCKET_COUNT];
+        std::atomic<uint64_t> total_ns[SCAN_STAGE_COUNT];
+        std::atomic<uint64_t> max_ns[SCAN_STAGE_COUNT];
+        std::atomic<uint64_t> frames;
+        std::atomic<uint64_t> codes;
+        std::atomic<uint64_t> budget_exhausted_frames;
+    };
+
+    Shard& currentShard();
+
+    Shard shards[SHARD_COUNT];
+};
+
+// One timed stage of a traced frame, relative to the frame start
+struct TraceSpan {
+    ScanStage stage;
+    std::chrono::nanoseconds start;
+    std::chrono::nanoseconds duration;
+    std::thread::id thread;
+};
+
+struct FrameTrace {
+    uint64_t frame_index;  // Frames this scanner has processed before
+    std::chrono::steady_clock::time_point start;
+    std::vector<TraceSpan> spans;  // In the order the stages finished
+    size_t codes;
+    bool budget_exhausted;
+};
+
+// Called on the scanning thread after every frame while set
+typedef std::function<void(const FrameTrace&)> FrameTraceCallback;
+
+// Collects the spans of the frame in flight. Spans can come from the
+// concurrent passes, so adding one takes a lock; nothing is collected
+// unless a frame was begun, i.e. unless someone asked for traces.
+class FrameTracer {
+public:
+    FrameTracer();
+
+    void begin(uint64_t frame_index);
+    bool isActive() const { return active.load(std::memory_order_relaxed); }
+    void addSpan(ScanStage stage, std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end);
+    const FrameTrace& finish(size_t codes, bool budget_exhausted);
+
+private:
+    std::mutex mutex;
+    FrameTrace trace;
+    std::atomic<bool> active;  // Only changed between frames, on the scanning thread
+};
+
+// Where a stage timer reports; either pointer may be null
+struct ScanInstrumentation {
+    ScanMetrics* metrics;
+    FrameTracer* tracer;
+};
+
+// Times the enclosing scope as one call of stage
+class ScopedStageTimer {
+public:
+    ScopedStageTimer(const ScanInstrumentation& instrumentation, ScanStage stage);
+    ~ScopedStageTimer();
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    ScanInstrumentation instrumentation;
+    ScanStage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Prometheus text exposition format: a barcode_scan_stage_seconds histogram
+// labelled by stage, plus frame, code and budget counters
+std::string formatPrometheusMetrics(const ScanStatistics& statistics);
+
+#endif // BARCODE_METRICS_H
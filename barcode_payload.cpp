@@ -0,0 +1,283 @@
+#include "barcode_payload.h"
+
+#include <algorithm>
+#include <cctype>
+
+static const char GS1_SEPARATOR = '\x1d';  // FNC1 inside a raw element string
+
+static bool startsWith(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool allDigits(std::string_view text) {
+    for (char c : text) {
+        if (!isDigit(c)) return false;
+    }
+    return !text.empty();
+}
+
+// GS1 symbology identifiers: GS1-128, DataBar, DataMatrix, QR Code, DotCode
+static bool isGs1SymbologyIdentifier(std::string_view text) {
+    return startsWith(text, "]C1") || startsWith(text, "]e0") || startsWith(text, "]d2") ||
+           startsWith(text, "]Q3") || startsWith(text, "]J1");
+}
+
+// "(" followed by 2-4 digits and ")"
+static size_t bracketedAiEnd(std::string_view text) {
+    if (text.empty() || text[0] != '(') return std::string_view::npos;
+    size_t close = text.find(')');
+    if (close == std::string_view::npos || close < 3 || close > 5) return std::string_view::npos;
+    return allDigits(text.substr(1, close - 1)) ? close : std::string_view::npos;
+}
+
+// AI length follows from its first two digits
+static size_t gs1AiLength(std::string_view ai) {
+    int prefix = (ai[0] - '0') * 10 + (ai[1] - '0');
+    if (prefix <= 22 || prefix == 30 || prefix == 37 || prefix >= 90) return 2;
+    if ((prefix >= 23 && prefix <= 25) || (prefix >= 40 && prefix <= 42) || prefix == 71) return 3;
+    return 4;
+}
+
+// Application identifiers of the GS1 General Specifications, as ranges of
+// AIs with the same length. Anything else in brackets is ordinary text,
+// e.g. the area code of "(555) 123-4567".
+struct Gs1AiRange {
+    size_t length;
+    int first;
+    int last;
+};
+
+static constexpr Gs1AiRange GS1_AI_RANGES[] = {
+    {2, 0, 2}, {2, 10, 13}, {2, 15, 17}, {2, 20, 22}, {2, 30, 30}, {2, 37, 37}, {2, 90, 99},
+    {3, 235, 235}, {3, 240, 243}, {3, 250, 251}, {3, 253, 255},
+    {3, 400, 403}, {3, 410, 417}, {3, 420, 427}, {3, 710, 717},
+    {4, 3100, 3169}, {4, 3200, 3699}, {4, 3900, 3955}, {4, 4300, 4326},
+    {4, 7001, 7011}, {4, 7020, 7023}, {4, 7030, 7041}, {4, 7230, 7259},
+    {4, 8001, 8013}, {4, 8017, 8020}, {4, 8026, 8026}, {4, 8030, 8030}, {4, 8110, 8112}, {4, 8200, 8200},
+};
+
+static bool isKnownGs1Ai(std::string_view ai) {
+    if (ai.size() < 2 || !allDigits(ai) || ai.size() != gs1AiLength(ai)) return false;
+    int number = 0;
+    for (char c : ai) number = number * 10 + (c - '0');
+    for (const Gs1AiRange& range : GS1_AI_RANGES) {
+        if (range.length == ai.size() && number >= range.first && number <= range.last) return true;
+    }
+    return false;
+}
+
+// Value length of the AIs with a predefined length, 0 for variable-length
+// ones, which end at the next separator
+static size_t gs1PredefinedValueLength(std::string_view ai) {
+    int prefix = (ai[0] - '0') * 10 + (ai[1] - '0');
+    switch (prefix) {
+        case 0: return 18;
+        case 1: case 2: case 3: return 14;
+        case 4: return 16;
+        case 11: case 12: case 13: case 14: case 15: case 16: case 17: case 18: case 19: return 6;
+        case 20: return 2;
+        case 31: case 32: case 33: case 34: case 35: case 36: return 6;
+        case 41: return 13;
+        default: return 0;
+    }
+}
+
+// A known AI with a value, of the predefined length where it has one
+static bool isValidGs1Element(const Gs1Element& element) {
+    if (!isKnownGs1Ai(element.ai) || element.value.empty()) return false;
+    size_t value_length = gs1PredefinedValueLength(element.ai);
+    return value_length == 0 || element.value.size() == value_length;
+}
+
+// Takes the next "(AI)value" off the front of text
+static bool splitBracketedElement(std::string_view& text, Gs1Element& element) {
+    size_t close = bracketedAiEnd(text);
+    if (close == std::string_view::npos) return false;
+
+    element.ai = text.substr(1, close - 1);
+    size_t value_end = text.find('(', close + 1);
+    element.value = text.substr(close + 1, value_end == std::string_view::npos ? std::string_view::npos
+                                                                              : value_end - close - 1);
+    text = value_end == std::string_view::npos ? std::string_view() : text.substr(value_end);
+    return true;
+}
+
+// Every bracket pair must be a known AI with a valid value, so text that
+// merely starts with digits in brackets is not taken for GS1
+static bool parsesAsBracketedGs1(std::string_view text) {
+    Gs1Element element;
+    while (!text.empty()) {
+        if (!splitBracketedElement(text, element) || !isValidGs1Element(element)) return false;
+    }
+    return true;
+}
+
+Gs1Tokenizer::Gs1Tokenizer(std::string_view data) : rest(data), format(NOT_GS1), error(false) {
+    if (bracketedAiEnd(rest) != std::string_view::npos) {
+        if (parsesAsBracketedGs1(rest)) format = BRACKETED;
+        return;
+    }
+
+    bool identified = isGs1SymbologyIdentifier(rest);
+    if (identified) rest.remove_prefix(3);
+    // FNC1 in first position
+    bool leading_fnc1 = !rest.empty() && rest[0] == GS1_SEPARATOR;
+    if (leading_fnc1) rest.remove_prefix(1);
+
+    if ((identified || leading_fnc1) && rest.size() >= 2 && isDigit(rest[0]) && isDigit(rest[1])) {
+        format = RAW;
+    }
+}
+
+bool Gs1Tokenizer::next(Gs1Element& element) {
+    if (error) return false;
+    switch (format) {
+        case BRACKETED: return nextBracketed(element);
+        case RAW: return nextRaw(element);
+        default: return false;
+    }
+}
+
+// The whole string was validated by the constructor
+bool Gs1Tokenizer::nextBracketed(Gs1Element& element) {
+    if (rest.empty()) return false;
+
+    if (!splitBracketedElement(rest, element)) {
+        error = true;
+        return false;
+    }
+    return true;
+}
+
+bool Gs1Tokenizer::nextRaw(Gs1Element& element) {
+    // A separator after a predefined-length element is allowed and ignored
+    while (!rest.empty() && rest[0] == GS1_SEPARATOR) rest.remove_prefix(1);
+    if (rest.empty()) return false;
+
+    if (rest.size() < 2 || !isDigit(rest[0]) || !isDigit(rest[1])) {
+        error = true;
+        return false;
+    }
+    size_t ai_length = gs1AiLength(rest);
+    if (rest.size() < ai_length || !isKnownGs1Ai(rest.substr(0, ai_length))) {
+        error = true;
+        return false;
+    }
+    element.ai = rest.substr(0, ai_length);
+
+    size_t value_length = gs1PredefinedValueLength(rest);
+    if (value_length > 0) {
+        if (rest.size() < ai_length + value_length) {
+            error = true;
+            return false;
+        }
+    } else {
+        size_t separator = rest.find(GS1_SEPARATOR, ai_length);
+        value_length = (separator == std::string_view::npos ? rest.size() : separator) - ai_length;
+    }
+
+    element.value = rest.substr(ai_length, value_length);
+    rest.remove_prefix(ai_length + value_length);
+    return true;
+}
+
+bool findGs1Element(std::string_view data, std::string_view ai, std::string_view& value) {
+    Gs1Tokenizer tokenizer(data);
+    Gs1Element element;
+    while (tokenizer.next(element)) {
+        if (element.ai == ai) {
+            value = element.value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseGtin(std::string_view digits, GtinView& gtin) {
+    size_t length = digits.size();
+    if ((length != 8 && length != 12 && length != 13 && length != 14) || !allDigits(digits)) return false;
+
+    // Weights alternate 3, 1, 3, ... leftwards from the digit before the check digit
+    int sum = 0;
+    for (size_t i = 0; i + 1 < length; ++i) {
+        int digit = digits[i] - '0';
+        sum += ((length - 2 - i) % 2 == 0) ? digit * 3 : digit;
+    }
+
+    gtin.digits = digits;
+    gtin.expected_check_digit = (10 - (sum % 10)) % 10;
+    gtin.check_digit_valid = gtin.expected_check_digit == digits.back() - '0';
+    return true;
+}
+
+// Splits at the next unescaped separator; WiFi payloads escape it with '\'
+static bool nextField(std::string_view& text, char separator, std::string_view& field) {
+    if (text.empty()) return false;
+
+    size_t end = 0;
+    while (end < text.size() && text[end] != separator) {
+        end += (text[end] == '\\' && end + 1 < text.size()) ? 2 : 1;
+    }
+    field = text.substr(0, end);
+    text = end < text.size() ? text.substr(end + 1) : std::string_view();
+    return true;
+}
+
+static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseWifi(std::string_view data, WifiView& wifi) {
+    if (!startsWith(data, "WIFI:")) return false;
+
+    wifi = WifiView();
+    std::string_view rest = data.substr(5);
+    std::string_view field;
+    while (nextField(rest, ';', field)) {
+        if (startsWith(field, "S:")) wifi.ssid = field.substr(2);
+        else if (startsWith(field, "T:")) wifi.security = field.substr(2);
+        else if (startsWith(field, "P:")) wifi.password = field.substr(2);
+        else if (startsWith(field, "H:")) wifi.hidden = equalsIgnoreCase(field.substr(2), "true");
+    }
+    return true;
+}
+
+bool parseVCard(std::string_view data, VCardView& vcard) {
+    if (data.find("BEGIN:VCARD") == std::string_view::npos) return false;
+
+    vcard = VCardView();
+    std::string_view rest = data;
+    std::string_view line;
+    while (nextField(rest, '\n', line)) {
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+        // Property names may carry parameters, e.g. "TEL;TYPE=CELL:..."
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view name = line.substr(0, std::min(colon, line.find(';')));
+        std::string_view value = line.substr(colon + 1);
+
+        if (vcard.name.empty() && equalsIgnoreCase(name, "FN")) vcard.name = value;
+        else if (vcard.phone.empty() && equalsIgnoreCase(name, "TEL")) vcard.phone = value;
+        else if (vcard.email.empty() && equalsIgnoreCase(name, "EMAIL")) vcard.email = value;
+    }
+    return true;
+}
+
+PayloadKind detectPayloadKind(std::string_view data) {
+    if (Gs1Tokenizer(data).isGs1()) return PAYLOAD_GS1;
+    if (startsWith(data, "http://") || startsWith(data, "https://")) return PAYLOAD_URL;
+    if (startsWith(data, "WIFI:")) return PAYLOAD_WIFI;
+    if (data.find("BEGIN:VCARD") != std::string_view::npos) return PAYLOAD_VCARD;
+    return PAYLOAD_TEXT;
+}
@@ -0,0 +1,83 @@
+#ifndef BARCODE_PAYLOAD_H
+#define BARCODE_PAYLOAD_H
+
+#include <string_view>
+
+// Structured views over decoded payloads, computed only when asked for.
+// Nothing here allocates: every field is a view into the payload that was
+// parsed and lives exactly as long as it does.
+
+enum PayloadKind {
+    PAYLOAD_TEXT,
+    PAYLOAD_URL,
+    PAYLOAD_VCARD,
+    PAYLOAD_WIFI,
+    PAYLOAD_GS1
+};
+
+PayloadKind detectPayloadKind(std::string_view data);
+
+struct GtinView {
+    std::string_view digits;   // Including the check digit
+    int expected_check_digit;  // Computed from the other digits
+    bool check_digit_valid;
+};
+
+// GTIN-8, -12, -13 or -14 (EAN/UPC payloads and GS1 AI 01); false for
+// anything that is not 8, 12, 13 or 14 digits
+bool parseGtin(std::string_view digits, GtinView& gtin);
+
+struct Gs1Element {
+    std::string_view ai;  // Application identifier, 2 to 4 digits
+    std::string_view value;
+};
+
+// Splits a GS1 element string into AI/value pairs without copying.
+// Accepts the bracketed form "(01)...(10)..." that ZXing reports by
+// default, when every bracket holds a known AI with a valid value, as well
+// as the raw form, where FNC1 arrives as GS (0x1D) after
+// an optional symbology identifier ("]C1", "]d2", "]Q3", ...). Raw
+// predefined-length AIs need no separator, as in the GS1 specification.
+class Gs1Tokenizer {
+public:
+    explicit Gs1Tokenizer(std::string_view data);
+
+    // False at the end of the string or at the first malformed element
+    bool next(Gs1Element& element);
+    bool isGs1() const { return format != NOT_GS1; }
+    bool failed() const { return error; }
+
+private:
+    enum Format { NOT_GS1, BRACKETED, RAW };
+
+    bool nextBracketed(Gs1Element& element);
+    bool nextRaw(Gs1Element& element);
+
+    std::string_view rest;
+    Format format;
+    bool error;
+};
+
+// Value of the first element with the given AI
+bool findGs1Element(std::string_view data, std::string_view ai, std::string_view& value);
+
+// "WIFI:S:<ssid>;T:<security>;P:<password>;H:true;;"
+struct WifiView {
+    std::string_view ssid;
+    std::string_view security;
+    std::string_view password;
+    bool hidden;
+};
+
+bool parseWifi(std::string_view data, WifiView& wifi);
+
+// First FN, TEL and EMAIL properties of a vCard
+struct VCardView {
+    std::string_view name;
+    std::string_view phone;
+    std::string_view email;
+};
+
+bool parseVCard(std::string_view data, VCardView& vcard);
+
+#endif // BARCODE_PAYLOAD_H
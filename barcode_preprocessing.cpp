@@ -0,0 +1,174 @@
+#include "barcode_preprocessing.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <opencv2/core/ocl.hpp>
+#include <opencv2/photo.hpp>  // for fastNlMeansDenoising
+
+std::vector<PreprocessStage> defaultLowResolutionStages() {
+    return {
+        PREPROCESS_UPSCALE_2X,
+        PREPROCESS_CLAHE,
+        PREPROCESS_DENOISE,
+        PREPROCESS_UNSHARP_MASK,
+        PREPROCESS_ADAPTIVE_THRESHOLD,
+        PREPROCESS_MORPH_CLOSE
+    };
+}
+
+DenoiseOptions defaultDenoiseOptions() {
+    DenoiseOptions options;
+    options.method = DENOISE_NL_MEANS;
+    options.skip_below_sigma = 3.0;
+    return options;
+}
+
+bool operator==(const DenoiseOptions& a, const DenoiseOptions& b) {
+    return a.method == b.method && a.skip_below_sigma == b.skip_below_sigma;
+}
+
+bool operator!=(const DenoiseOptions& a, const DenoiseOptions& b) {
+    return !(a == b);
+}
+
+double estimateNoiseSigma(const cv::Mat& gray, cv::Mat& scratch) {
+    if (gray.rows < 3 || gray.cols < 3) return 0.0;
+
+    static const cv::Mat kernel = (cv::Mat_<float>(3, 3) << 1, -2, 1, -2, 4, -2, 1, -2, 1);
+    // At most 16 x 255, so 16 bits hold the response
+    cv::filter2D(gray, scratch, CV_16S, kernel);
+
+    // The border rows and columns see the border extrapolation, not the image
+    cv::Mat inner = scratch(cv::Rect(1, 1, gray.cols - 2, gray.rows - 2));
+    double pixels = static_cast<double>(inner.total());
+    return std::sqrt(CV_PI / 2.0) * cv::norm(inner, cv::NORM_L1) / (6.0 * pixels);
+}
+
+PreprocessingPipeline::PreprocessingPipeline(const std::vector<PreprocessStage>& pipeline_stages,
+                                             PreprocessDevice requested_device, const DenoiseOptions& denoise_options)
+    : stages(pipeline_stages), scale_factor(1.0), instrumentation{nullptr, nullptr}, device(requested_device),
+      denoise(denoise_options) {
+    if (device == PREPROCESS_DEVICE_OPENCL && !(cv::ocl::haveOpenCL() && cv::ocl::useOpenCL())) {
+        device = PREPROCESS_DEVICE_CPU;
+    }
+    for (PreprocessStage stage : stages) {
+        if (stage == PREPROCESS_UPSCALE_2X) scale_factor *= 2.0;
+    }
+    clahe = cv::createCLAHE(3.0, cv::Size(8, 8));
+    morph_kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+}
+
+// The stages over cv::Mat on the host or cv::UMat on the OpenCL device;
+// every call has a transparent-API implementation. Device calls are queued
+// and only waited for when the result is downloaded.
+template <typename Image>
+static const Image& runStages(const std::vector<PreprocessStage>& stages, const Image& gray, Image (&buffers)[2],
+                              Image& blurred, Image& edges, cv::CLAHE& clahe, const cv::Mat& morph_kernel,
+                              DenoiseMethod denoise, bool skip_denoise, const ScanInstrumentation& instrumentation) {
+    const Image* input = &gray;
+    int next = 0;
+
+    for (PreprocessStage stage : stages) {
+        Image& output = buffers[next];
+        if (stage == PREPROCESS_DENOISE && skip_denoise) continue;
+
+        switch (stage) {
+            case PREPROCESS_UPSCALE_2X:
+                cv::resize(*input, output, cv::Size(), 2.0, 2.0, cv::INTER_CUBIC);
+                break;
+            case PREPROCESS_CLAHE:
+                clahe.apply(*input, output);
+                break;
+            case PREPROCESS_DENOISE: {
+                ScopedStageTimer denoise_timer(instrumentation, SCAN_STAGE_DENOISE);
+                switch (denoise) {
+                    case DENOISE_NL_MEANS: cv::fastNlMeansDenoising(*input, output, 10, 7, 21); break;
+                    case DENOISE_BILATERAL: cv::bilateralFilter(*input, output, 5, 30, 5); break;
+                    case DENOISE_MEDIAN: cv::medianBlur(*input, output, 3); break;
+                    case DENOISE_BOX: cv::blur(*input, output, cv::Size(3, 3)); break;
+                }
+                break;
+            }
+            case PREPROCESS_UNSHARP_MASK:
+                // Only the positive part of the mask is added, as uchar subtraction saturates
+                cv::GaussianBlur(*input, blurred, cv::Size(0, 0), 3);
+                cv::subtract(*input, blurred, edges);
+                cv::addWeighted(*input, 1.0, edges, 0.7, 0, output);
+                break;
+            case PREPROCESS_ADAPTIVE_THRESHOLD:
+                cv::adaptiveThreshold(*input, output, 255, cv::ADAPTIVE_THRESH_GAUSSIAN_C, cv::THRESH_BINARY, 21, 5);
+                break;
+            case PREPROCESS_MORPH_CLOSE:
+                cv::morphologyEx(*input, output, cv::MORPH_CLOSE, morph_kernel);
+                break;
+        }
+
+        input = &output;
+        next ^= 1;
+    }
+
+    return *input;
+}
+
+const cv::Mat& PreprocessingPipeline::run(const cv::Mat& gray) {
+    if (stages.empty()) return gray;
+
+    ScopedStageTimer chain_timer(instrumentation, SCAN_STAGE_PREPROCESS);
+    // Clean frames skip the denoiser. Measured on the chain's input, before
+    // any upscale smooths the noise; a tile or localiser region is judged on
+    // its own pixels.
+    bool skip_denoise = false;
+    if (denoise.skip_below_sigma > 0 &&
+        std::find(stages.begin(), stages.end(), PREPROCESS_DENOISE) != stages.end()) {
+        skip_denoise = estimateNoiseSigma(gray, noise_response) < denoise.skip_below_sigma;
+    }
+
+    if (device == PREPROCESS_DEVICE_CPU) {
+        return runStages(stages, gray, buffers, blurred, edges, *clahe, morph_kernel, denoise.method, skip_denoise,
+                         instrumentation);
+    }
+
+    // Denoise is timed as queued on the device; the chain timer covers the
+    // whole round trip, as the download waits for the queue
+    gray.copyTo(device_input);
+    const cv::UMat& output = runStages(stages, device_input, device_buffers, device_blurred, device_edges, *clahe,
+                                       morph_kernel, denoise.method, skip_denoise, instrumentation);
+    output.copyTo(downloaded);
+    return downloaded;
+}
+
+double PreprocessingPipeline::getScaleFactor() const {
+    return scale_factor;
+}
+
+const std::vector<PreprocessStage>& PreprocessingPipeline::getStages() const {
+    return stages;
+}
+
+void PreprocessingPipeline::setInstrumentation(const ScanInstrumentation& instr) {
+    instrumentation = instr;
+}
+
+bool PreprocessingPipeline::empty() const {
+    return stages.empty();
+}
+
+PreprocessDevice PreprocessingPipeline::getDevice() const {
+    return device;
+}
+
+const DenoiseOptions& PreprocessingPipeline::getDenoiseOptions() const {
+    return denoise;
+}
+
+size_t PreprocessingPipeline::getBufferBytes() const {
+    size_t bytes = 0;
+    for (const cv::Mat* buffer : {&buffers[0], &buffers[1], &blurred, &edges, &noise_response, &downloaded}) {
+        bytes += buffer->total() * buffer->elemSize();
+    }
+    for (const cv::UMat* buffer : {&device_input, &device_buffers[0], &device_buffers[1], &device_blurred, &device_edges}) {
+        bytes += buffer->total() * buffer->elemSize();
+    }
+    return bytes;
+}
@@ -0,0 +1,104 @@
+#ifndef BARCODE_PREPROCESSING_H
+#define BARCODE_PREPROCESSING_H
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "barcode_metrics.h"
+
+// Stages of the low-resolution enhancement chain, applied in the order given
+enum PreprocessStage {
+    PREPROCESS_UPSCALE_2X,          // Bicubic 2x upscale
+    PREPROCESS_CLAHE,               // Adaptive histogram equalization
+    PREPROCESS_DENOISE,             // See DenoiseOptions; non-local means is by far the most expensive stage
+    PREPROCESS_UNSHARP_MASK,        // Edge enhancement
+    PREPROCESS_ADAPTIVE_THRESHOLD,  // Gaussian adaptive binarization
+    PREPROCESS_MORPH_CLOSE          // 3x3 close to fill gaps in bars
+};
+
+// Where the chain runs
+enum PreprocessDevice {
+    PREPROCESS_DEVICE_CPU,     // cv::Mat on the calling thread
+    PREPROCESS_DEVICE_OPENCL   // cv::UMat through OpenCV's transparent API, on the default OpenCL device
+};
+
+// Filters PREPROCESS_DENOISE can run, most thorough first
+enum DenoiseMethod {
+    DENOISE_NL_MEANS,   // fastNlMeansDenoising, h 10, 7x7 patches, 21x21 search
+    DENOISE_BILATERAL,  // 5x5 edge-preserving bilateral filter
+    DENOISE_MEDIAN,     // 3x3 median, removes speckle and keeps bar edges
+    DENOISE_BOX         // 3x3 separable box blur, the cheapest
+};
+
+struct DenoiseOptions {
+    DenoiseMethod method;
+    double skip_below_sigma;  // Frames with less estimated noise (gray levels) skip the stage; 0 always denoises
+};
+
+// Non-local means, skipped for frames with a noise sigma under 3
+DenoiseOptions defaultDenoiseOptions();
+
+bool operator==(const DenoiseOptions& a, const DenoiseOptions& b);
+bool operator!=(const DenoiseOptions& a, const DenoiseOptions& b);
+
+// Standard deviation of the noise in gray, in gray levels, by Immerkaer's
+// method: the mean absolute response to a Laplacian-difference kernel that
+// cancels edges and smooth gradients. One filter pass over the image.
+// scratch holds the filter response between calls.
+double estimateNoiseSigma(const cv::Mat& gray, cv::Mat& scratch);
+
+// The chain main.cpp always ran before it became configurable
+std::vector<PreprocessStage> defaultLowResolutionStages();
+
+// Runs a fixed list of stages over a grayscale image. CLAHE and the
+// morphology kernel are created once, and every stage writes into
+// buffers kept between calls, so steady-state frames do not allocate.
+// On PREPROCESS_DEVICE_OPENCL the input is uploaded once, every stage runs
+// on device buffers and only the chain's output is downloaded.
+//
+// Not thread-safe; each scanner owns its own pipeline.
+class PreprocessingPipeline {
+public:
+    // Falls back to the CPU when OpenCL is requested but not available or
+    // turned off with cv::ocl::setUseOpenCL(false)
+    explicit PreprocessingPipeline(const std::vector<PreprocessStage>& stages = defaultLowResolutionStages(),
+                                   PreprocessDevice device = PREPROCESS_DEVICE_CPU,
+                                   const DenoiseOptions& denoise = defaultDenoiseOptions());
+
+    // The result lives in an internal buffer and stays valid until the next
+    // call; with no stages the input itself is returned
+    const cv::Mat& run(const cv::Mat& gray);
+
+    // Output size over input size, to map positions back to the frame
+    double getScaleFactor() const;
+    const std::vector<PreprocessStage>& getStages() const;
+    bool empty() const;
+    // The device the chain actually runs on
+    PreprocessDevice getDevice() const;
+    const DenoiseOptions& getDenoiseOptions() const;
+    // Times the chain and its denoise stage from the next run() on
+    void setInstrumentation(const ScanInstrumentation& instrumentation);
+    // Memory held by the stage buffers, on the host and the device
+    size_t getBufferBytes() const;
+
+private:
+    std::vector<PreprocessStage> stages;
+    double scale_factor;
+    ScanInstrumentation instrumentation;
+    cv::Ptr<cv::CLAHE> clahe;
+    cv::Mat morph_kernel;
+    cv::Mat buffers[2];  // Stages ping-pong between these
+    cv::Mat blurred;     // Scratch for the unsharp mask
+    cv::Mat edges;
+    cv::Mat noise_response;  // Scratch for the noise estimate
+    PreprocessDevice device;
+    DenoiseOptions denoise;
+    cv::UMat device_input;       // The frame, uploaded once per run()
+    cv::UMat device_buffers[2];
+    cv::UMat device_blurred;
+    cv::UMat device_edges;
+    cv::Mat downloaded;          // The chain's output, back on the host
+};
+
+#endif // BARCODE_PREPROCESSING_H
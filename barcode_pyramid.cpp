@@ -0,0 +1,141 @@
+#include "barcode_pyramid.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+// Below this the scanline is background or noise, not a code
+static const int MIN_SCANLINE_CONTRAST = 40;
+// Fewer runs than this say nothing about the module size
+static const size_t MIN_REGION_RUNS = 8;
+
+MultiScaleOptions defaultMultiScaleOptions() {
+    MultiScaleOptions options;
+    options.scales = {1.0, 1.5, 2.0};
+    options.target_module_px = 3.0;
+    options.scanlines_per_region = 5;
+    return options;
+}
+
+// Appends the lengths of the runs between the first and last transition of
+// one scanline; the outer runs are cut off by the region and are skipped
+static void collectRunLengths(const uint8_t* pixels, int count, int stride, std::vector<int>& runs) {
+    int low = 255, high = 0;
+    for (int i = 0; i < count; ++i) {
+        int value = pixels[i * stride];
+        low = std::min(low, value);
+        high = std::max(high, value);
+    }
+    if (high - low < MIN_SCANLINE_CONTRAST) return;
+
+    int threshold = (low + high) / 2;
+    bool dark = pixels[0] < threshold;
+    int run_start = -1;  // Unknown until the first transition
+    for (int i = 1; i < count; ++i) {
+        bool pixel_dark = pixels[i * stride] < threshold;
+        if (pixel_dark == dark) continue;
+        if (run_start >= 0) runs.push_back(i - run_start);
+        run_start = i;
+        dark = pixel_dark;
+    }
+}
+
+double estimateModuleSize(const cv::Mat& gray, const std::vector<cv::Rect>& regions, int scanlines_per_region) {
+    if (gray.type() != CV_8UC1) {
+        throw std::runtime_error("Module size estimation needs an 8-bit grayscale image");
+    }
+
+    const cv::Rect frame(0, 0, gray.cols, gray.rows);
+    double module_size = 0.0;
+    std::vector<int> runs;
+
+    for (const cv::Rect& candidate : regions) {
+        cv::Rect region = candidate & frame;
+        if (region.width < 2 || region.height < 2) continue;
+
+        runs.clear();
+        for (int line = 1; line <= scanlines_per_region; ++line) {
+            int y = region.y + region.height * line / (scanlines_per_region + 1);
+            collectRunLengths(gray.ptr<uint8_t>(y) + region.x, region.width, 1, runs);
+
+            int x = region.x + region.width * line / (scanlines_per_region + 1);
+            collectRunLengths(gray.ptr<uint8_t>(region.y) + x, region.height, static_cast<int>(gray.step), runs);
+        }
+        if (runs.size() < MIN_REGION_RUNS) continue;
+
+        // Most runs are one or two modules wide, so a low percentile is the
+        // module; noise only makes it smaller, which costs a scale but no code
+        auto percentile = runs.begin() + runs.size() / 5;
+        std::nth_element(runs.begin(), percentile, runs.end());
+        double region_module = *percentile;
+        if (module_size == 0.0 || region_module < module_size) module_size = region_module;
+    }
+
+    return module_size;
+}
+
+std::vector<double> selectPyramidScales(double module_size, const MultiScaleOptions& options) {
+    if (module_size <= 0.0 || options.scales.empty()) return options.scales;
+
+    std::vector<double> ascending = options.scales;
+    std::sort(ascending.begin(), ascending.end());
+
+    double needed = options.target_module_px / module_size;
+    auto adequate = std::lower_bound(ascending.begin(), ascending.end(), needed);
+    if (adequate == ascending.end()) --adequate;
+
+    std::vector<double> selected;
+    for (auto it = adequate + 1; it != ascending.begin();) {
+        selected.push_back(*--it);
+    }
+    return selected;
+}
+
+ImagePyramid::ImagePyramid(FrameBufferPool& buffer_pool) : pool(buffer_pool) {}
+
+void ImagePyramid::reset(const cv::Mat& base_image, const std::vector<double>& scales, const cv::Mat& half_image) {
+    base = base_image;
+    half = half_image;
+    levels.clear();
+    levels.reserve(scales.size());
+    for (double scale : scales) {
+        levels.push_back(Level{scale, FrameBufferPool::Buffer(), cv::Mat()});
+    }
+}
+
+void ImagePyramid::clear() {
+    base = cv::Mat();
+    half = cv::Mat();
+    levels.clear();
+}
+
+size_t ImagePyramid::size() const {
+    return levels.size();
+}
+
+double ImagePyramid::scale(size_t index) const {
+    return levels[index].scale;
+}
+
+const cv::Mat& ImagePyramid::level(size_t index) {
+    Level& level = levels[index];
+    if (!level.image.empty()) return level.image;
+
+    if (level.scale == 1.0) {
+        level.image = base;
+        return level.image;
+    }
+    // Already downsampled by the luma pass; on odd sizes it drops the last
+    // row or column where a resize would round up
+    if (level.scale == 0.5 && !half.empty()) {
+        level.image = half;
+        return level.image;
+    }
+
+    // Sized up front so resize() writes into the pooled buffer
+    cv::Size size(cvRound(base.cols * level.scale), cvRound(base.rows * level.scale));
+    level.buffer = pool.acquire(size.height, size.width, base.type());
+    cv::resize(base, level.buffer.mat(), size, 0, 0, level.scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+    level.image = level.buffer.mat();
+    return level.image;
+}
@@ -0,0 +1,62 @@
+#ifndef BARCODE_PYRAMID_H
+#define BARCODE_PYRAMID_H
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "barcode_buffer_pool.h"
+
+// Tuning for the multi-scale decode loop
+struct MultiScaleOptions {
+    std::vector<double> scales;  // Candidate levels, relative to the base image
+    double target_module_px;     // Module size the decoders are most reliable at
+    int scanlines_per_region;    // Rows and columns sampled per region for the estimate
+};
+
+MultiScaleOptions defaultMultiScaleOptions();
+
+// Estimated size of one module (narrowest bar or 2D cell), in pixels of
+// gray, from the run lengths along a few scanlines through every region.
+// The smallest region estimate wins, so the hardest code decides the
+// scales. 0 when no region had enough contrast to measure.
+double estimateModuleSize(const cv::Mat& gray, const std::vector<cv::Rect>& regions, int scanlines_per_region);
+
+// Scales worth decoding at, best first: the smallest scale that brings the
+// module up to the target, then the smaller ones in case the estimate was
+// pessimistic. Larger scales only add work and are dropped. Without an
+// estimate every scale is tried, in the order given.
+std::vector<double> selectPyramidScales(double module_size, const MultiScaleOptions& options);
+
+// Resized copies of one base image, one per scale, built on first use from
+// pooled storage and shared by every decode of the frame. Distinct levels
+// may be built from different threads at once.
+class ImagePyramid {
+public:
+    explicit ImagePyramid(FrameBufferPool& pool);
+
+    // Drops the previous levels; base must outlive the pyramid's use of it.
+    // half, when given, is base 2x2 box-filtered (LumaPlanes::half) and is
+    // the 0.5 level as is, instead of a resize of base.
+    void reset(const cv::Mat& base, const std::vector<double>& scales, const cv::Mat& half = cv::Mat());
+    // Returns the level buffers to the pool
+    void clear();
+
+    size_t size() const;
+    double scale(size_t index) const;
+    const cv::Mat& level(size_t index);
+
+private:
+    struct Level {
+        double scale;
+        FrameBufferPool::Buffer buffer;
+        cv::Mat image;  // base itself at scale 1.0, half at 0.5 when given
+    };
+
+    FrameBufferPool& pool;
+    cv::Mat base;
+    cv::Mat half;
+    std::vector<Level> levels;
+};
+
+#endif // BARCODE_PYRAMID_H
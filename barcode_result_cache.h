@@ -0,0 +1,175 @@
+#ifndef BARCODE_RESULT_CACHE_H
+#define BARCODE_RESULT_CACHE_H
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// Tuning for the decode-result cache
+struct ResultCacheOptions {
+    size_t capacity;                    // Recent frames remembered, the oldest is replaced first
+    int max_hash_distance;              // Differing hash bits (of 256) still treated as the same scene
+    std::chrono::milliseconds max_age;  // Entries older than this are not reused
+    bool verify;                        // Re-decode only the cached codes' regions instead of trusting them
+    double verify_margin;               // Verified region grows by this fraction of the code size per side
+};
+
+inline ResultCacheOptions defaultResultCacheOptions() {
+    ResultCacheOptions options;
+    options.capacity = 8;
+    options.max_hash_distance = 12;
+    options.max_age = std::chrono::milliseconds(2000);
+    options.verify = true;
+    options.verify_margin = 0.25;
+    return options;
+}
+
+// Difference hash of a 16x16 grid: bit i is set when cell i is brighter
+// than its right neighbour. Survives exposure changes, sensor noise and
+// recompression; a moved or different parcel flips many bits.
+typedef std::array<uint64_t, 4> FrameHash;
+
+inline FrameHash computeFrameHash(const cv::Mat& gray) {
+    cv::Mat grid;
+    cv::resize(gray, grid, cv::Size(17, 16), 0, 0, cv::INTER_AREA);
+
+    FrameHash hash = {};
+    for (int y = 0; y < 16; ++y) {
+        const uint8_t* row = grid.ptr<uint8_t>(y);
+        for (int x = 0; x < 16; ++x) {
+            int bit = y * 16 + x;
+            if (row[x] > row[x + 1]) hash[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+    return hash;
+}
+
+inline int frameHashDistance(const FrameHash& a, const FrameHash& b) {
+    int distance = 0;
+    for (size_t i = 0; i < a.size(); ++i) distance += static_cast<int>(std::bitset<64>(a[i] ^ b[i]).count());
+    return distance;
+}
+
+enum ResultCacheOutcome {
+    RESULT_CACHE_HIT,           // Served from the cache, verified if verify is on
+    RESULT_CACHE_MISS,          // No recent frame looked alike, decoded in full
+    RESULT_CACHE_VERIFY_FAILED  // A frame looked alike but its codes did not re-decode, decoded in full
+};
+
+struct ResultCacheStatistics {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t verify_failures;
+    size_t entries;
+};
+
+// Results of the last few frames, keyed by their FrameHash and the
+// DecoderPlan::plan_id they were decoded with; plan ids are unique in the
+// process, so scanners with different settings never share entries. Label
+// stations show the same parcel for many consecutive frames, and a
+// near-identical frame can reuse (or cheaply verify) what the first one
+// decoded instead of running every engine again. Only complete, non-empty
+// frame results should be stored.
+//
+// Works on any result type. Thread-safe, so every scanner of a pool can
+// share one cache.
+template <typename Result>
+class FrameResultCache {
+public:
+    explicit FrameResultCache(const ResultCacheOptions& options = defaultResultCacheOptions())
+        : options(options), next_entry(0), hits(0), misses(0), verify_failures(0) {}
+
+    const ResultCacheOptions& getOptions() const { return options; }
+
+    // Copies the results of the closest recent frame within
+    // max_hash_distance into results
+    bool lookup(const FrameHash& hash, uint64_t plan_id, std::vector<Result>& results) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const Entry* entry = closestEntry(hash, plan_id, std::chrono::steady_clock::now());
+        if (!entry) return false;
+        results = entry->results;
+        return true;
+    }
+
+    // Replaces the entry lookup() would have returned, so a scene that stays
+    // put is kept fresh instead of filling the cache with copies of itself
+    void store(const FrameHash& hash, uint64_t plan_id, const std::vector<Result>& results) {
+        if (options.capacity == 0) return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+        Entry* entry = closestEntry(hash, plan_id, now);
+        if (!entry) {
+            if (entries.size() < options.capacity) {
+                entries.emplace_back();
+                entry = &entries.back();
+            } else {
+                entry = &entries[next_entry];
+                next_entry = (next_entry + 1) % entries.size();
+            }
+        }
+        entry->hash = hash;
+        entry->plan_id = plan_id;
+        entry->stored = now;
+        entry->results = results;
+    }
+
+    void record(ResultCacheOutcome outcome) {
+        std::lock_guard<std::mutex> lock(mutex);
+        switch (outcome) {
+            case RESULT_CACHE_HIT: ++hits; break;
+            case RESULT_CACHE_MISS: ++misses; break;
+            case RESULT_CACHE_VERIFY_FAILED: ++verify_failures; break;
+        }
+    }
+
+    ResultCacheStatistics getStatistics() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return ResultCacheStatistics{hits, misses, verify_failures, entries.size()};
+    }
+
+    // Forgets the entries, the counters are kept
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        next_entry = 0;
+    }
+
+private:
+    struct Entry {
+        FrameHash hash;
+        uint64_t plan_id;
+        std::chrono::steady_clock::time_point stored;
+        std::vector<Result> results;
+    };
+
+    Entry* closestEntry(const FrameHash& hash, uint64_t plan_id, std::chrono::steady_clock::time_point now) {
+        Entry* best = nullptr;
+        int best_distance = options.max_hash_distance + 1;
+        for (auto& entry : entries) {
+            if (entry.plan_id != plan_id || now - entry.stored > options.max_age) continue;
+            int distance = frameHashDistance(entry.hash, hash);
+            if (distance < best_distance) {
+                best = &entry;
+                best_distance = distance;
+            }
+        }
+        return best;
+    }
+
+    ResultCacheOptions options;
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;
+    size_t next_entry;  // Replaced next once the cache is full
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t verify_failures;
+};
+
+#endif // BARCODE_RESULT_CACHE_H
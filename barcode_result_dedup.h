@@ -0,0 +1,102 @@
+#ifndef BARCODE_RESULT_DEDUP_H
+#define BARCODE_RESULT_DEDUP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Merge stage for results coming from several engines or passes over the
+// same frame. Works on any result type with data, symbology, location and
+// confidence members, so both scanners share it. Locations must already be
+// in frame coordinates.
+
+// Same code seen twice: one box holds the other's center, or they overlap
+// by at least half of the smaller one. Measured against the smaller box
+// rather than as IoU because ZBar reports 1D codes as a thin box along its
+// scanline, which a full ZXing box around the same code barely overlaps.
+inline bool barcodeLocationsOverlap(const cv::Rect& a, const cv::Rect& b) {
+    cv::Point a_center(a.x + a.width / 2, a.y + a.height / 2);
+    cv::Point b_center(b.x + b.width / 2, b.y + b.height / 2);
+    if (b.contains(a_center) || a.contains(b_center)) return true;
+
+    int smaller_area = std::min(a.area(), b.area());
+    return smaller_area > 0 && (a & b).area() * 2 >= smaller_area;
+}
+
+// Clusters results by payload through a hash index, then by location among
+// the copies of one payload, and keeps the most confident report of every
+// code. Ties keep the earlier report, so add engines in order of
+// preference. Identical payloads at different places (two copies of the
+// same label) stay separate codes.
+//
+// Not thread-safe.
+template <typename Result>
+class BarcodeResultMerger {
+public:
+    // True when result is a new code rather than another report of one
+    // already held
+    bool add(Result result) {
+        size_t key = keyOf(result);
+        auto range = index.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it) {
+            Result& kept = merged[it->second];
+            if (kept.symbology != result.symbology || kept.data != result.data ||
+                !barcodeLocationsOverlap(kept.location, result.location)) {
+                continue;
+            }
+            if (result.confidence > kept.confidence) kept = std::move(result);
+            return false;
+        }
+
+        index.emplace(key, merged.size());
+        merged.push_back(std::move(result));
+        return true;
+    }
+
+    // Number of new codes among results
+    int addAll(std::vector<Result>&& results) {
+        int added = 0;
+        for (auto& result : results) {
+            if (add(std::move(result))) ++added;
+        }
+        results.clear();
+        return added;
+    }
+
+    size_t size() const { return merged.size(); }
+
+    // The merged codes in the order they were first reported; empties the merger
+    std::vector<Result> take() {
+        index.clear();
+        std::vector<Result> results;
+        results.swap(merged);
+        return results;
+    }
+
+private:
+    static size_t keyOf(const Result& result) {
+        size_t payload_hash = std::hash<std::string_view>()(std::string_view(result.data));
+        return payload_hash * 31 + static_cast<size_t>(result.symbology);
+    }
+
+    std::vector<Result> merged;
+    std::unordered_multimap<size_t, size_t> index;  // Payload key to position in merged
+};
+
+// Merges results in place, see BarcodeResultMerger
+template <typename Result>
+void mergeDuplicateResults(std::vector<Result>& results) {
+    if (results.size() < 2) return;
+
+    BarcodeResultMerger<Result> merger;
+    merger.addAll(std::move(results));
+    results = merger.take();
+}
+
+#endif // BARCODE_RESULT_DEDUP_H
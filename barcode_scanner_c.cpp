@@ -0,0 +1,223 @@
+#include "barcode_scanner_c.h"
+
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "barcode_scanner_lib.h"
+#include "barcode_scanner_pool.h"
+
+static_assert(BS_OK == static_cast<int>(SCAN_SUCCESS) && BS_NO_CODES_FOUND == static_cast<int>(SCAN_NO_CODES_FOUND) &&
+              BS_PROCESSING_ERROR == static_cast<int>(SCAN_PROCESSING_ERROR) &&
+              BS_INVALID_IMAGE == static_cast<int>(SCAN_INVALID_IMAGE) &&
+              BS_PARTIAL_BUDGET_EXHAUSTED == static_cast<int>(SCAN_PARTIAL_BUDGET_EXHAUSTED),
+              "bs_status must match ScanStatus");
+static_assert(BS_PIXEL_FORMAT_GRAY == static_cast<int>(PIXEL_FORMAT_GRAY) && BS_PIXEL_FORMAT_BGR == static_cast<int>(PIXEL_FORMAT_BGR) &&
+              BS_PIXEL_FORMAT_BGRA == static_cast<int>(PIXEL_FORMAT_BGRA) && BS_PIXEL_FORMAT_NV12 == static_cast<int>(PIXEL_FORMAT_NV12) &&
+              BS_PIXEL_FORMAT_YUYV == static_cast<int>(PIXEL_FORMAT_YUYV),
+              "bs_pixel_format must match PixelFormat");
+static_assert(BS_SYMBOLOGY_CODE128 == static_cast<int>(SymbologyType::Code128) &&
+              BS_SYMBOLOGY_DATAMATRIX == static_cast<int>(SymbologyType::DataMatrix) &&
+              BS_SYMBOLOGY_AZTEC == static_cast<int>(SymbologyType::Aztec) &&
+              BS_SYMBOLOGY_AZTEC + 1 == SYMBOLOGY_COUNT,
+              "bs_symbology must match SymbologyType");
+
+struct bs_scanner {
+    std::shared_ptr<RecognitionContext> context;
+    std::unique_ptr<BarcodeScannerPool> pool;
+    std::vector<ImageDescription> frames;  // Views of the current batch, capacity kept
+    std::mutex mutex;                      // Serialises bs_scan_batch()
+    std::string last_error;
+};
+
+// Exceptions stop here; what they said is kept for bs_scanner_last_error()
+template <typename Function>
+static bs_status guarded(bs_scanner* scanner, Function function) {
+    try {
+        return function();
+    } catch (const std::invalid_argument& e) {
+        if (scanner) scanner->last_error = e.what();
+        return BS_INVALID_ARGUMENT;
+    } catch (const std::exception& e) {
+        if (scanner) scanner->last_error = e.what();
+        return BS_PROCESSING_ERROR;
+    } catch (...) {
+        if (scanner) scanner->last_error = "Unknown error";
+        return BS_PROCESSING_ERROR;
+    }
+}
+
+static int bytesPerPixel(int32_t pixel_format) {
+    switch (pixel_format) {
+        case BS_PIXEL_FORMAT_GRAY: return 1;
+        case BS_PIXEL_FORMAT_BGR: return 3;
+        case BS_PIXEL_FORMAT_BGRA: return 4;
+        case BS_PIXEL_FORMAT_NV12: return 1;
+        case BS_PIXEL_FORMAT_YUYV: return 2;
+        default: return 0;
+    }
+}
+
+static std::shared_ptr<BarcodeScannerSettings> createSettings(const bs_scanner_options& options) {
+    if (options.symbologies == 0) throw std::invalid_argument("No symbology enabled");
+    if (options.max_codes_per_frame <= 0) throw std::invalid_argument("max_codes_per_frame must be positive");
+
+    auto settings = createScannerSettings(options.realtime ? PRESET_REALTIME_MODE : PRESET_SINGLE_FRAME_MODE);
+    // Bits outside bs_symbology are ignored
+    const SymbologyMask known = ((SymbologyMask(1) << SYMBOLOGY_COUNT) - 1) & ~symbologyBit(SymbologyType::None);
+    settings->setEnabledSymbologyMask(options.symbologies & known);
+    settings->setColorInvertedMask(options.inverted & known);
+    settings->setMaxCodesPerFrame(options.max_codes_per_frame);
+    settings->setSearchWholeImage(options.search_whole_image != 0);
+    settings->setTryHarderMode(options.try_harder != 0);
+    if (options.frame_budget_us >= 0) settings->setFrameBudget(std::chrono::microseconds(options.frame_budget_us));
+    return settings;
+}
+
+extern "C" {
+
+uint32_t bs_abi_version(void) {
+    return BS_ABI_VERSION;
+}
+
+const char* bs_status_name(bs_status status) {
+    switch (status) {
+        case BS_OK: return "ok";
+        case BS_NO_CODES_FOUND: return "no_codes_found";
+        case BS_PROCESSING_ERROR: return "processing_error";
+        case BS_INVALID_IMAGE: return "invalid_image";
+        case BS_PARTIAL_BUDGET_EXHAUSTED: return "partial_budget_exhausted";
+        case BS_INVALID_ARGUMENT: return "invalid_argument";
+        case BS_SINK_FULL: return "sink_full";
+        default: return "unknown";
+    }
+}
+
+void bs_scanner_options_init(bs_scanner_options* options) {
+    if (!options) return;
+
+    // configureScannerForShippingLabels()
+    options->realtime = 0;
+    options->symbologies = SHIPPING_LABEL_SYMBOLOGIES;
+    options->inverted = SHIPPING_LABEL_INVERTED_SYMBOLOGIES;
+    options->max_codes_per_frame = 10;
+    options->search_whole_image = 1;
+    options->try_harder = 1;
+    options->frame_budget_us = -1;
+    options->worker_count = 0;
+}
+
+bs_status bs_scanner_create(const bs_scanner_options* options, bs_scanner** scanner) {
+    if (!scanner) return BS_INVALID_ARGUMENT;
+    *scanner = nullptr;
+
+    bs_scanner_options defaults;
+    if (!options) {
+        bs_scanner_options_init(&defaults);
+        options = &defaults;
+    }
+
+    return guarded(nullptr, [&] {
+        std::unique_ptr<bs_scanner> created(new bs_scanner());
+        created->context = createRecognitionContext();
+        created->pool.reset(new BarcodeScannerPool(created->context, createSettings(*options), options->worker_count));
+        created->context->startNewFrameSequence();
+        *scanner = created.release();
+        return BS_OK;
+    });
+}
+
+void bs_scanner_destroy(bs_scanner* scanner) {
+    if (!scanner) return;
+    try {
+        scanner->context->endFrameSequence();
+    } catch (...) {
+    }
+    delete scanner;
+}
+
+bs_status bs_scan_batch(bs_scanner* scanner, const bs_image* images, size_t n, bs_result_sink* sink) {
+    if (!scanner || !sink || (n > 0 && !images)) return BS_INVALID_ARGUMENT;
+
+    std::lock_guard<std::mutex> lock(scanner->mutex);
+    scanner->last_error.clear();
+    sink->result_count = 0;
+    sink->results_needed = 0;
+    sink->text_size = 0;
+    sink->text_needed = 0;
+
+    return guarded(scanner, [&] {
+        // Zero-copy views of the caller's pixels, only read while the pool runs
+        scanner->frames.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const bs_image& image = images[i];
+            int bytes_per_pixel = bytesPerPixel(image.pixel_format);
+            if (bytes_per_pixel == 0) throw std::invalid_argument("Unknown pixel format");
+            // cv::Mat throws on these, which would fail the batch as a processing error
+            if (image.width < 0 || image.height < 0) throw std::invalid_argument("Negative image width or height");
+            if (image.row_bytes != 0 && image.row_bytes < image.width * bytes_per_pixel) {
+                throw std::invalid_argument("row_bytes is smaller than one row of pixels");
+            }
+            // Null or empty frames become views without data and come back as
+            // SCAN_INVALID_IMAGE
+            scanner->frames.push_back(createImageDescriptionView(image.pixels, image.width, image.height, image.row_bytes,
+                                                                 static_cast<PixelFormat>(image.pixel_format)));
+        }
+
+        std::vector<FrameScanResult> scanned = scanner->pool->processFrames(scanner->frames);
+
+        bs_status status = BS_OK;
+        bool sink_full = false;
+        for (size_t i = 0; i < scanned.size(); ++i) {
+            bs_status frame_status = static_cast<bs_status>(scanned[i].status);
+            if (sink->statuses) sink->statuses[i] = frame_status;
+            if (status == BS_OK && (frame_status == BS_INVALID_IMAGE || frame_status == BS_PROCESSING_ERROR)) {
+                status = frame_status;
+            }
+
+            for (const BarcodeResult& result : scanned[i].results) {
+                ++sink->results_needed;
+                sink->text_needed += result.data.size();
+                // Once one result does not fit, later ones are only counted so
+                // the written results stay a prefix of the batch
+                if (sink_full || sink->result_count == sink->result_capacity ||
+                    sink->text_capacity - sink->text_size < result.data.size()) {
+                    sink_full = true;
+                    continue;
+                }
+
+                // The only copy on the way out: the payload, into the caller's arena
+                char* text = sink->text + sink->text_size;
+                if (!result.data.empty()) std::memcpy(text, result.data.data(), result.data.size());
+                sink->text_size += result.data.size();
+
+                bs_result& out = sink->results[sink->result_count++];
+                out.image_index = static_cast<uint32_t>(i);
+                out.symbology = static_cast<int32_t>(result.symbology);
+                out.data = text;
+                out.data_size = result.data.size();
+                out.x = result.location.x;
+                out.y = result.location.y;
+                out.width = result.location.width;
+                out.height = result.location.height;
+                out.confidence = result.confidence;
+                out.color_inverted = result.is_color_inverted ? 1 : 0;
+            }
+        }
+        scanner->frames.clear();
+
+        if (status == BS_OK && sink_full) status = BS_SINK_FULL;
+        return status;
+    });
+}
+
+const char* bs_scanner_last_error(const bs_scanner* scanner) {
+    return scanner ? scanner->last_error.c_str() : "";
+}
+
+}  // extern "C"
@@ -0,0 +1,150 @@
+#ifndef BARCODE_SCANNER_C_H
+#define BARCODE_SCANNER_C_H
+
+/*
+ * C ABI over BarcodeScannerPool for embedding the scanner in other
+ * languages. Only plain C types cross the boundary: no OpenCV, ZXing or dmtx
+ * types, no C++ exceptions (every call returns a bs_status) and no memory
+ * allocated by the library that the caller has to free.
+ *
+ * Pixels are borrowed: bs_scan_batch() reads them only while it runs and
+ * never copies a whole frame. Results are written into buffers the caller
+ * owns and can reuse from batch to batch.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define BS_API __attribute__((visibility("default")))
+#else
+#define BS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a struct layout or function signature changes */
+#define BS_ABI_VERSION 1
+
+typedef enum bs_status {
+    BS_OK = 0,
+    BS_NO_CODES_FOUND = 1,
+    BS_PROCESSING_ERROR = 2,
+    BS_INVALID_IMAGE = 3,
+    BS_PARTIAL_BUDGET_EXHAUSTED = 4, /* Frame budget ran out, results may be incomplete */
+    BS_INVALID_ARGUMENT = 5,
+    BS_SINK_FULL = 6                 /* See bs_result_sink */
+} bs_status;
+
+/* Same values as PixelFormat */
+typedef enum bs_pixel_format {
+    BS_PIXEL_FORMAT_GRAY = 0,
+    BS_PIXEL_FORMAT_BGR = 1,
+    BS_PIXEL_FORMAT_BGRA = 2,
+    BS_PIXEL_FORMAT_NV12 = 3, /* Only the leading Y plane is read */
+    BS_PIXEL_FORMAT_YUYV = 4
+} bs_pixel_format;
+
+/* Same values as SymbologyType; masks use bit (1 << symbology) */
+typedef enum bs_symbology {
+    BS_SYMBOLOGY_NONE = 0,
+    BS_SYMBOLOGY_CODE128 = 1,
+    BS_SYMBOLOGY_CODE39 = 2,
+    BS_SYMBOLOGY_CODE93 = 3,
+    BS_SYMBOLOGY_EAN = 4,
+    BS_SYMBOLOGY_EAN13 = 5,
+    BS_SYMBOLOGY_EAN8 = 6,
+    BS_SYMBOLOGY_UPCA = 7,
+    BS_SYMBOLOGY_UPCE = 8,
+    BS_SYMBOLOGY_DATAMATRIX = 9,
+    BS_SYMBOLOGY_QR_CODE = 10,
+    BS_SYMBOLOGY_PDF417 = 11,
+    BS_SYMBOLOGY_AZTEC = 12
+} bs_symbology;
+
+typedef struct bs_scanner_options {
+    int32_t realtime;             /* Non-zero for PRESET_REALTIME_MODE's budget and defaults */
+    uint32_t symbologies;         /* Mask of enabled symbologies, must not be 0 */
+    uint32_t inverted;            /* Symbologies also searched for light-on-dark */
+    int32_t max_codes_per_frame;
+    int32_t search_whole_image;
+    int32_t try_harder;
+    int64_t frame_budget_us;      /* 0 disables the budget, negative keeps the preset's */
+    uint32_t worker_count;        /* 0 uses every core */
+} bs_scanner_options;
+
+/* One borrowed frame; row_bytes 0 means tightly packed */
+typedef struct bs_image {
+    const uint8_t* pixels;
+    int32_t width;
+    int32_t height;
+    int32_t row_bytes;
+    int32_t pixel_format; /* bs_pixel_format */
+} bs_image;
+
+/* data points into the sink's text arena and is not NUL-terminated */
+typedef struct bs_result {
+    uint32_t image_index; /* Position of the frame in the batch */
+    int32_t symbology;    /* bs_symbology */
+    const char* data;
+    size_t data_size;
+    int32_t x, y, width, height;
+    double confidence;
+    int32_t color_inverted;
+} bs_result;
+
+/*
+ * Caller-owned output of one batch. Results come in batch order. When either
+ * buffer is too small, as much as fits is written, results_needed and
+ * text_needed say how much the whole batch needs and the call returns
+ * BS_SINK_FULL, so the caller can grow the buffers and scan again.
+ */
+typedef struct bs_result_sink {
+    bs_result* results;
+    size_t result_capacity;
+    size_t result_count;     /* Out */
+    size_t results_needed;   /* Out */
+
+    char* text;
+    size_t text_capacity;
+    size_t text_size;        /* Out */
+    size_t text_needed;      /* Out */
+
+    bs_status* statuses;     /* Optional, one per image */
+} bs_result_sink;
+
+typedef struct bs_scanner bs_scanner;
+
+BS_API uint32_t bs_abi_version(void);
+BS_API const char* bs_status_name(bs_status status);
+
+/* Shipping-label defaults, single-frame preset */
+BS_API void bs_scanner_options_init(bs_scanner_options* options);
+
+/* options may be NULL for the defaults */
+BS_API bs_status bs_scanner_create(const bs_scanner_options* options, bs_scanner** scanner);
+BS_API void bs_scanner_destroy(bs_scanner* scanner);
+
+/*
+ * Scans n frames on the scanner's worker pool and blocks until all are done.
+ * Returns the status of the first frame that failed (BS_INVALID_IMAGE or
+ * BS_PROCESSING_ERROR), else BS_SINK_FULL if the results did not fit, else
+ * BS_OK, also when frames had no codes or ran out of budget (see statuses).
+ * An unknown pixel format, a negative width or height or a row_bytes
+ * shorter than a row fails the whole call with BS_INVALID_ARGUMENT before
+ * any frame is scanned. Frames are scanned independently, in any order,
+ * without temporal tracking even with realtime set. Calls on one scanner
+ * are serialised.
+ */
+BS_API bs_status bs_scan_batch(bs_scanner* scanner, const bs_image* images, size_t n, bs_result_sink* sink);
+
+/* Message of the last failure on this scanner, valid until the next call */
+BS_API const char* bs_scanner_last_error(const bs_scanner* scanner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BARCODE_SCANNER_C_H */
@@ -4,53 +4,167 @@
 #include <ZXing/ZXingCpp.h>
 #include <ZXing/ReadBarcode.h>
 #include <ZXing/Flags.h>
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <iterator>
+#include <thread>
 
-extern "C" {
-#include <dmtx.h>
-}
+#include "barcode_decoder_backend.h"
+#include "barcode_logger.h"
+
+// Process-wide, so settings objects that happen to reach the same
+// generation still compile plans with different ids
+static std::atomic<uint64_t> next_plan_id(1);
 
 // Implementations for BarcodeScannerSettings class
-BarcodeScannerSettings::BarcodeScannerSettings() : max_codes_per_frame(1), search_whole_image(false), try_harder_mode(false) {
-    // Initialize all symbologies to false
-    for (int i = 0; i < static_cast<int>(SymbologyType::Aztec) + 1; ++i) {
-        enabled_symbologies[static_cast<SymbologyType>(i)] = false;
-        color_inverted[static_cast<SymbologyType>(i)] = false;
+BarcodeScannerSettings::BarcodeScannerSettings(ScanPreset preset)
+    : enabled_symbologies(0), color_inverted(0), max_codes_per_frame(1),
+      search_whole_image(true), try_harder_mode(false),
+      frame_budget(preset == PRESET_REALTIME_MODE ? DEFAULT_REALTIME_FRAME_BUDGET : std::chrono::microseconds(0)),
+      temporal_tracking(preset == PRESET_REALTIME_MODE), escalate_preprocessing(true),
+      preprocessing_device(PREPROCESS_DEVICE_CPU), denoise(defaultDenoiseOptions()), tiling(defaultTilingOptions()), preset_mode(preset),
+      generation(1), plan_id(next_plan_id.fetch_add(1)) {
+    for (int i = 0; i < SYMBOLOGY_COUNT; ++i) {
+        engine_routes[i] = defaultEngineRoute(static_cast<SymbologyType>(i));
     }
 }
 
+void BarcodeScannerSettings::markChanged() {
+    ++generation;
+    plan_id = next_plan_id.fetch_add(1);
+}
+
 void BarcodeScannerSettings::setSymbologyEnabled(SymbologyType symbology, bool enabled) {
-    enabled_symbologies[symbology] = enabled;
+    SymbologyMask updated = enabled ? (enabled_symbologies | symbologyBit(symbology))
+                                    : (enabled_symbologies & ~symbologyBit(symbology));
+    if (updated != enabled_symbologies) {
+        enabled_symbologies = updated;
+        markChanged();
+    }
 }
 
 void BarcodeScannerSettings::setColorInvertedEnabled(SymbologyType symbology, bool enabled) {
-    color_inverted[symbology] = enabled;
+    SymbologyMask updated = enabled ? (color_inverted | symbologyBit(symbology))
+                                    : (color_inverted & ~symbologyBit(symbology));
+    if (updated != color_inverted) {
+        color_inverted = updated;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setEnabledSymbologyMask(SymbologyMask symbologies) {
+    if (symbologies != enabled_symbologies) {
+        enabled_symbologies = symbologies;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setColorInvertedMask(SymbologyMask symbologies) {
+    if (symbologies != color_inverted) {
+        color_inverted = symbologies;
+        markChanged();
+    }
 }
 
 void BarcodeScannerSettings::setMaxCodesPerFrame(int max_codes) {
-    max_codes_per_frame = max_codes;
+    if (max_codes != max_codes_per_frame) {
+        max_codes_per_frame = max_codes;
+        markChanged();
+    }
 }
 
 void BarcodeScannerSettings::setSearchWholeImage(bool search) {
-    search_whole_image = search;
+    if (search != search_whole_image) {
+        search_whole_image = search;
+        markChanged();
+    }
 }
 
 void BarcodeScannerSettings::setTryHarderMode(bool try_harder) {
-    try_harder_mode = try_harder;
+    if (try_harder != try_harder_mode) {
+        try_harder_mode = try_harder;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setFrameBudget(std::chrono::microseconds budget) {
+    if (budget < std::chrono::microseconds(0)) budget = std::chrono::microseconds(0);
+    if (budget != frame_budget) {
+        frame_budget = budget;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setTemporalTrackingEnabled(bool enabled) {
+    if (enabled != temporal_tracking) {
+        temporal_tracking = enabled;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setPreprocessingStages(const std::vector<PreprocessStage>& stages) {
+    if (stages != preprocessing_stages) {
+        preprocessing_stages = stages;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setPreprocessingEscalation(bool enabled) {
+    if (enabled != escalate_preprocessing) {
+        escalate_preprocessing = enabled;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setPreprocessingDevice(PreprocessDevice device) {
+    if (device != preprocessing_device) {
+        preprocessing_device = device;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setDenoiseOptions(const DenoiseOptions& options) {
+    if (options != denoise) {
+        denoise = options;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setTiling(const TilingOptions& options) {
+    if (options != tiling) {
+        tiling = options;
+        markChanged();
+    }
+}
+
+void BarcodeScannerSettings::setEngineRoute(SymbologyType symbology, const EngineRoute& route) {
+    EngineRoute supported;
+    for (DecoderEngine engine : route) {
+        if (engine < 0 || engine >= ENGINE_COUNT || !(getEngineSymbologies(engine) & symbologyBit(symbology))) continue;
+        if (std::find(supported.begin(), supported.end(), engine) == supported.end()) supported.push_back(engine);
+    }
+    if (supported.empty()) supported = defaultEngineRoute(symbology);
+    
+    EngineRoute& current = engine_routes[static_cast<int>(symbology)];
+    if (supported != current) {
+        current = supported;
+        markChanged();
+    }
 }
 
 std::set<SymbologyType> BarcodeScannerSettings::getEnabledSymbologies() const {
     std::set<SymbologyType> enabled;
-    for (const auto& pair : enabled_symbologies) {
-        if (pair.second) {
-            enabled.insert(pair.first);
+    for (int i = 0; i < SYMBOLOGY_COUNT; ++i) {
+        if (enabled_symbologies & symbologyBit(static_cast<SymbologyType>(i))) {
+            enabled.insert(static_cast<SymbologyType>(i));
         }
     }
     return enabled;
 }
 
 bool BarcodeScannerSettings::isColorInverted(SymbologyType symbology) const {
-    auto it = color_inverted.find(symbology);
-    return it != color_inverted.end() && it->second;
+    return (color_inverted & symbologyBit(symbology)) != 0;
 }
 
 int BarcodeScannerSettings::getMaxCodesPerFrame() const {
@@ -66,36 +180,215 @@ bool BarcodeScannerSettings::getTryHarderMode() const {
 }
 
 bool BarcodeScannerSettings::isSymbologyEnabled(SymbologyType symbology) const {
-    auto it = enabled_symbologies.find(symbology);
-    return it != enabled_symbologies.end() && it->second;
+    return (enabled_symbologies & symbologyBit(symbology)) != 0;
+}
+
+std::chrono::microseconds BarcodeScannerSettings::getFrameBudget() const {
+    return frame_budget;
+}
+
+bool BarcodeScannerSettings::isTemporalTrackingEnabled() const {
+    return temporal_tracking;
+}
+
+const std::vector<PreprocessStage>& BarcodeScannerSettings::getPreprocessingStages() const {
+    return preprocessing_stages;
+}
+
+bool BarcodeScannerSettings::getPreprocessingEscalation() const {
+    return escalate_preprocessing;
+}
+
+PreprocessDevice BarcodeScannerSettings::getPreprocessingDevice() const {
+    return preprocessing_device;
+}
+
+const DenoiseOptions& BarcodeScannerSettings::getDenoiseOptions() const {
+    return denoise;
+}
+
+const TilingOptions& BarcodeScannerSettings::getTiling() const {
+    return tiling;
+}
+
+const EngineRoute& BarcodeScannerSettings::getEngineRoute(SymbologyType symbology) const {
+    return engine_routes[static_cast<int>(symbology)];
+}
+
+ScanPreset BarcodeScannerSettings::getPresetMode() const {
+    return preset_mode;
+}
+
+SymbologyMask BarcodeScannerSettings::getEnabledSymbologyMask() const {
+    return enabled_symbologies;
+}
+
+SymbologyMask BarcodeScannerSettings::getColorInvertedMask() const {
+    return color_inverted;
+}
+
+uint64_t BarcodeScannerSettings::getGeneration() const {
+    return generation;
+}
+
+// Undecodable symbols ZXing may return on top of max_codes_per_frame
+static const int MAX_ZXING_ERROR_RESULTS = 8;
+
+std::shared_ptr<const DecoderPlan> BarcodeScannerSettings::compileDecoderPlan() const {
+    auto compiled = std::make_shared<DecoderPlan>();
+    compiled->generation = generation;
+    compiled->plan_id = plan_id;
+    compiled->enabled_symbologies = enabled_symbologies;
+    compiled->color_inverted_symbologies = color_inverted;
+    
+    // Split the enabled symbologies between the engines their routes name,
+    // and order the engines by how early any route asks for them
+    int first_rank[ENGINE_COUNT];
+    bool preferred[ENGINE_COUNT] = {};
+    std::fill(std::begin(first_rank), std::end(first_rank), ENGINE_COUNT);
+    std::fill(std::begin(compiled->engine_symbologies), std::end(compiled->engine_symbologies), 0);
+    for (int i = 0; i < SYMBOLOGY_COUNT; ++i) {
+        SymbologyType symbology = static_cast<SymbologyType>(i);
+        if (!(enabled_symbologies & symbologyBit(symbology))) continue;
+        
+        const EngineRoute& route = engine_routes[i];
+        for (size_t rank = 0; rank < route.size(); ++rank) {
+            compiled->engine_symbologies[route[rank]] |= symbologyBit(symbology);
+            first_rank[route[rank]] = std::min(first_rank[route[rank]], static_cast<int>(rank));
+            if (rank == 0) preferred[route[rank]] = true;
+        }
+    }
+    
+    for (int engine = 0; engine < ENGINE_COUNT; ++engine) {
+        if (compiled->engine_symbologies[engine]) {
+            compiled->engine_steps.push_back({static_cast<DecoderEngine>(engine), !preferred[engine]});
+        }
+    }
+    // Ties keep the cheapest-first enum order
+    std::stable_sort(compiled->engine_steps.begin(), compiled->engine_steps.end(),
+                     [&](const EngineStep& a, const EngineStep& b) { return first_rank[a.engine] < first_rank[b.engine]; });
+    
+    // Engines that cannot invert on their own get an inverted copy, but only
+    // for the symbologies with color inversion on
+    compiled->run_inverted_pass = false;
+    for (int engine = 0; engine < ENGINE_COUNT; ++engine) {
+        SymbologyMask inverted = engineDecodesInverted(static_cast<DecoderEngine>(engine))
+                                     ? 0 : compiled->engine_symbologies[engine] & color_inverted;
+        // ZXing already tries inverted DataMatrix and hands libdmtx the ones it
+        // located, with their polarity, so a full-frame libdmtx search of the
+        // inverted copy would only repeat that work every frame
+        if (engine == ENGINE_LIBDMTX) inverted &= ~compiled->engine_symbologies[ENGINE_ZXING];
+        compiled->inverted_symbologies[engine] = inverted;
+        compiled->run_inverted_pass = compiled->run_inverted_pass || inverted != 0;
+    }
+    
+    SymbologyMask zxing_symbologies = compiled->engine_symbologies[ENGINE_ZXING];
+    compiled->zxing_formats = getZXingFormats(zxing_symbologies);
+    compiled->zxing_options.setTryHarder(try_harder_mode);
+    compiled->zxing_options.setTryRotate(true);
+    compiled->zxing_options.setFormats(compiled->zxing_formats);
+    // ZXing binarizes once and retries the inverted bitmap itself, stopping
+    // early when max_codes_per_frame is reached, which is far cheaper than a
+    // second pass over a materialised inverted image
+    compiled->zxing_options.setTryInvert((zxing_symbologies & color_inverted) != 0);
+    // DataMatrix candidates ZXing failed to decode tell libdmtx where to look.
+    // Failed reads count against ZXing's symbol limit, so it gets room for
+    // them and the backend stops at max_codes_per_frame valid codes itself.
+    bool return_errors = compiled->engine_symbologies[ENGINE_LIBDMTX] != 0;
+    compiled->zxing_options.setReturnErrors(return_errors);
+    compiled->zxing_options.setMaxNumberOfSymbols(return_errors ? max_codes_per_frame + MAX_ZXING_ERROR_RESULTS
+                                                                : max_codes_per_frame);
+    compiled->preprocessing_stages = preprocessing_stages;
+    compiled->escalate_preprocessing = escalate_preprocessing;
+    compiled->preprocessing_device = preprocessing_device;
+    compiled->denoise = denoise;
+    compiled->tiling = tiling;
+    compiled->max_codes_per_frame = max_codes_per_frame;
+    compiled->search_whole_image = search_whole_image;
+    compiled->frame_budget = frame_budget;
+    compiled->temporal_tracking = temporal_tracking;
+    return compiled;
+}
+
+// Implementations for ScanCancellationToken class
+ScanCancellationToken::ScanCancellationToken(int target)
+    : found_codes(0), cancelled(false), target_codes(target) {
+}
+
+void ScanCancellationToken::reportFound(const BarcodeResult& result) {
+    std::lock_guard<std::mutex> lock(seen_mutex);
+    if (seen.add(result) && ++found_codes >= target_codes) {
+        cancelled = true;
+    }
+}
+
+void ScanCancellationToken::reportFound(const std::vector<BarcodeResult>& results) {
+    for (const auto& result : results) reportFound(result);
+}
+
+void ScanCancellationToken::cancel() {
+    cancelled = true;
+}
+
+bool ScanCancellationToken::isCancelled() const {
+    return cancelled.load(std::memory_order_relaxed);
+}
+
+// Implementations for FrameDeadline class
+FrameDeadline::FrameDeadline(std::chrono::microseconds budget)
+    : deadline(std::chrono::steady_clock::now() + budget),
+      unlimited(budget <= std::chrono::microseconds(0)), exhausted(false) {
+}
+
+bool FrameDeadline::isUnlimited() const {
+    return unlimited;
+}
+
+bool FrameDeadline::expired() const {
+    return !unlimited && std::chrono::steady_clock::now() >= deadline;
+}
+
+std::chrono::microseconds FrameDeadline::remaining() const {
+    if (unlimited) return std::chrono::microseconds::max();
+    auto left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+    return left > std::chrono::microseconds(0) ? left : std::chrono::microseconds(0);
+}
+
+void FrameDeadline::markExhausted() {
+    exhausted = true;
+}
+
+bool FrameDeadline::wasExhausted() const {
+    return exhausted.load();
 }
 
 // Implementations for RecognitionContext class
 RecognitionContext::RecognitionContext() {
     frame_sequence_started = false;
+    frame_sequence_id = 0;
     initialized = true;
-    std::cout << "Recognition context created successfully" << std::endl;
+    BARCODE_LOG_INFO("Recognition context created successfully");
 }
 
 RecognitionContext::~RecognitionContext() {
     if (frame_sequence_started) {
         endFrameSequence();
     }
-    std::cout << "Recognition context released" << std::endl;
+    BARCODE_LOG_INFO("Recognition context released");
 }
 
 bool RecognitionContext::startNewFrameSequence() {
     if (!initialized) return false;
     
+    ++frame_sequence_id;
     frame_sequence_started = true;
-    std::cout << "New frame sequence started" << std::endl;
+    BARCODE_LOG_DEBUG("New frame sequence started");
     return true;
 }
 
 void RecognitionContext::endFrameSequence() {
-    if (frame_sequence_started) {
-        frame_sequence_started = false;
-        std::cout << "Frame sequence ended" << std::endl;
+    if (frame_sequence_started.exchange(false)) {
+        BARCODE_LOG_DEBUG("Frame sequence ended");
     }
 }
 
@@ -103,361 +396,885 @@ bool RecognitionContext::isFrameSequenceStarted() const {
     return frame_sequence_started;
 }
 
+uint64_t RecognitionContext::getFrameSequenceId() const {
+    return frame_sequence_id;
+}
+
 bool RecognitionContext::isInitialized() const {
     return initialized;
 }
 
+void RecognitionContext::enableResultCache(const ResultCacheOptions& options) {
+    result_cache.reset(new FrameResultCache<BarcodeResult>(options));
+    BARCODE_LOG_DEBUG("Result cache enabled for " << options.capacity << " frame(s)");
+}
+
+void RecognitionContext::disableResultCache() {
+    result_cache.reset();
+}
+
+FrameResultCache<BarcodeResult>* RecognitionContext::getResultCache() const {
+    return result_cache.get();
+}
+
+ResultCacheStatistics RecognitionContext::getResultCacheStatistics() const {
+    if (!result_cache) return ResultCacheStatistics{0, 0, 0, 0};
+    return result_cache->getStatistics();
+}
+
 // Implementations for BarcodeScanner class
 BarcodeScanner::BarcodeScanner(std::shared_ptr<RecognitionContext> ctx, std::shared_ptr<BarcodeScannerSettings> sett) 
-    : context(ctx), settings(sett), setup_completed(false) {
+    : context(ctx), settings(sett), configured_generation(0), preprocessing(std::vector<PreprocessStage>()),
+      pyramid(buffer_pool), multi_scale_options(defaultMultiScaleOptions()), peak_workspace_bytes(0),
+      metrics(std::make_shared<ScanMetrics>()), frame_tracer(&tracer), frames_processed(0), tracked_sequence_id(0), concurrent_inversion(true),
+      setup_completed(false) {
     
     if (!context || !context->isInitialized()) {
         throw std::runtime_error("Invalid recognition context");
     }
     
+    for (int engine = 0; engine < ENGINE_COUNT; ++engine) {
+        backends[engine] = createDecoderBackend(static_cast<DecoderEngine>(engine));
+    }
+    
     setup_completed = true;
-    std::cout << "Barcode scanner created successfully" << std::endl;
+    BARCODE_LOG_INFO("Barcode scanner created successfully");
+}
+
+BarcodeScanner::~BarcodeScanner() = default;
+
+void BarcodeScanner::setConcurrentInversion(bool enabled) {
+    concurrent_inversion = enabled;
+}
+
+ScanTaskWorker::ScanTaskWorker() : busy(false), stopping(false) {
+}
+
+ScanTaskWorker::~ScanTaskWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_ready.notify_one();
+    if (thread.joinable()) thread.join();
+}
+
+void ScanTaskWorker::start(std::function<void()> next_task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = std::move(next_task);
+        failure = nullptr;
+        busy = true;
+    }
+    if (!thread.joinable()) thread = std::thread(&ScanTaskWorker::run, this);
+    task_ready.notify_one();
+}
+
+void ScanTaskWorker::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    task_done.wait(lock, [this] { return !busy; });
+    if (failure) std::rethrow_exception(failure);
+}
+
+void ScanTaskWorker::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        task_ready.wait(lock, [this] { return busy || stopping; });
+        if (!busy) return;
+
+        std::function<void()> current = std::move(task);
+        lock.unlock();
+        std::exception_ptr thrown;
+        try {
+            current();
+        } catch (...) {
+            thrown = std::current_exception();
+        }
+        lock.lock();
+
+        failure = thrown;
+        busy = false;
+        task_done.notify_all();
+    }
 }
 
 bool BarcodeScanner::waitForSetupCompleted() {
-    std::cout << "Scanner setup completed" << std::endl;
+    BARCODE_LOG_INFO("Scanner setup completed");
     return setup_completed;
 }
 
 ScanStatus BarcodeScanner::processFrame(const ImageDescription& image_desc) {
+    return processFrame(image_desc, last_scan_results);
+}
+
+ScanStatus BarcodeScanner::processFrame(const ImageDescription& image_desc, std::vector<BarcodeResult>& results) {
+    if (trace_callback) tracer.begin(frames_processed);
+    ++frames_processed;
+    
+    ScanStatus status;
+    {
+        ScopedStageTimer frame_timer(instrumentation(), SCAN_STAGE_FRAME);
+        status = scanFrame(image_desc, results);
+    }
+    
+    bool exhausted = status == SCAN_PARTIAL_BUDGET_EXHAUSTED;
+    metrics->recordFrame(results.size(), exhausted);
+    if (trace_callback) trace_callback(tracer.finish(results.size(), exhausted));
+    return status;
+}
+
+// Below this a half-size ZXing pass saves too little to pay for the module
+// size estimate
+static const size_t MIN_HALF_PLANE_PIXELS = 1280 * 720;
+
+ScanStatus BarcodeScanner::scanFrame(const ImageDescription& image_desc, std::vector<BarcodeResult>& results) {
+    // Clear previous results, which also lets the previous frame's arena be reused
+    results.clear();
+    BarcodeTextArena::recycle(text_arena);
+    
     if (!context->isFrameSequenceStarted()) {
-        std::cout << "Error: Frame sequence not started" << std::endl;
+        BARCODE_LOG_ERROR("Error: Frame sequence not started");
         return SCAN_PROCESSING_ERROR;
     }
     
     if (image_desc.image_data.empty()) {
-        std::cout << "Error: Invalid image data" << std::endl;
+        BARCODE_LOG_WARNING("Error: Invalid image data");
         return SCAN_INVALID_IMAGE;
     }
     
-    std::cout << "Processing frame: " << image_desc.width << "x" << image_desc.height 
-             << " (" << image_desc.channels << " channels)" << std::endl;
+    BARCODE_LOG_DEBUG("Processing frame: " << image_desc.width << "x" << image_desc.height 
+             << " (" << image_desc.channels << " channels)");
+    
+    const DecoderPlan& plan = currentPlan();
+    FrameDeadline deadline(plan.frame_budget);
     
-    // Clear previous results
-    last_scan_results.clear();
+    // Single-channel inputs (GRAY, the Y plane of NV12) are scanned in place,
+    // others are converted into the reused luma buffer. When the inverted
+    // pass scans the whole frame, that plane comes out of the same pass;
+    // localiser and tracker regions are small and invert their own pixels.
+    // So does the half plane ZXing tries large untiled frames at first.
+    bool whole_frame = plan.search_whole_image && !plan.temporal_tracking;
+    bool invert_frame = whole_frame && plan.run_inverted_pass;
+    bool halve_frame = whole_frame && plan.engine_symbologies[ENGINE_ZXING] != 0 &&
+                       (plan.escalate_preprocessing || preprocessing.empty()) &&
+                       image_desc.image_data.total() >= MIN_HALF_PLANE_PIXELS &&
+                       computeTileGrid(image_desc.image_data.size(), plan.tiling).empty();
+    {
+        ScopedStageTimer luma_timer(instrumentation(), SCAN_STAGE_LUMA);
+        extractLumaPlanes(image_desc.image_data, (invert_frame ? LUMA_PLANE_INVERTED : 0) | (halve_frame ? LUMA_PLANE_HALF : 0),
+                          luma_planes);
+    }
+    const cv::Mat& gray_image = luma_planes.luma;
+    const cv::Mat& inverted_image = luma_planes.inverted;
+    
+    // The tracker already narrows a steady scene down to its codes' regions
+    FrameResultCache<BarcodeResult>* cache = plan.temporal_tracking ? nullptr : context->getResultCache();
+    FrameHash frame_hash = {};
+    bool served_from_cache = false;
+    if (cache) {
+        frame_hash = computeFrameHash(gray_image);
+        std::vector<BarcodeResult> cached;
+        ResultCacheOutcome outcome = RESULT_CACHE_MISS;
+        if (cache->lookup(frame_hash, plan.plan_id, cached)) {
+            const ResultCacheOptions& options = cache->getOptions();
+            if (!options.verify) {
+                // The cached texts keep their own frame's arena alive
+                results = std::move(cached);
+                served_from_cache = true;
+            } else {
+                served_from_cache = verifyCachedResults(gray_image, cached, options.verify_margin, plan, deadline, results);
+            }
+            outcome = served_from_cache ? RESULT_CACHE_HIT : RESULT_CACHE_VERIFY_FAILED;
+        }
+        cache->record(outcome);
+    }
     
-    // Convert to grayscale if needed
-    cv::Mat gray_image;
-    if (image_desc.channels == 3) {
-        cv::cvtColor(image_desc.image_data, gray_image, cv::COLOR_BGR2GRAY);
+    if (served_from_cache) {
+        BARCODE_LOG_DEBUG("Frame matches a cached one, " << results.size() << " code(s) reused");
+    } else if (plan.temporal_tracking) {
+        results = processTracked(gray_image, plan, deadline);
     } else {
-        gray_image = image_desc.image_data.clone();
+        if (!tracker.empty()) tracker.reset();
+        results = processFullFrame(gray_image, inverted_image, plan, deadline);
     }
+    // Drop the views, luma may share the caller's frame
+    luma_planes.luma = cv::Mat();
+    luma_planes.inverted = cv::Mat();
+    luma_planes.half = cv::Mat();
+    pyramid.clear();
+    updateWorkspacePeak();
     
-    // Process with potential color inversion
-    last_scan_results = processWithColorInversion(gray_image);
+    // Engines and passes can report the same code; the first report wins ties
+    {
+        ScopedStageTimer merge_timer(instrumentation(), SCAN_STAGE_MERGE);
+        mergeDuplicateResults(results);
+    }
+    
+    // Only complete frames with codes are worth reusing; verified hits
+    // refresh their entry with the current locations. An unverified hit
+    // leaves its entry alone, otherwise it would never reach max_age.
+    bool unverified_hit = served_from_cache && !cache->getOptions().verify;
+    if (cache && !unverified_hit && !results.empty() && !deadline.wasExhausted()) {
+        cache->store(frame_hash, plan.plan_id, results);
+    }
     
-    std::cout << "Scanning completed. Found " << last_scan_results.size() << " barcode(s)" << std::endl;
+    BARCODE_LOG_DEBUG("Scanning completed. Found " << results.size() << " barcode(s)");
     
-    return last_scan_results.empty() ? SCAN_NO_CODES_FOUND : SCAN_SUCCESS;
+    if (deadline.wasExhausted()) return SCAN_PARTIAL_BUDGET_EXHAUSTED;
+    return results.empty() ? SCAN_NO_CODES_FOUND : SCAN_SUCCESS;
+}
+
+ScanStatus BarcodeScanner::processFrame(const uint8_t* pixels, int width, int height, int row_bytes, PixelFormat format) {
+    if (!pixels || width <= 0 || height <= 0) {
+        BARCODE_LOG_WARNING("Error: Invalid image data");
+        return SCAN_INVALID_IMAGE;
+    }
+    ImageDescription desc = createImageDescriptionView(pixels, width, height, row_bytes, format);
+    if (desc.image_data.empty()) return SCAN_INVALID_IMAGE;  // row_bytes did not fit width
+    return processFrame(desc);
+}
+
+const DecoderPlan& BarcodeScanner::currentPlan() {
+    if (!plan || plan->generation != settings->getGeneration()) {
+        plan = settings->compileDecoderPlan();
+    }
+    // Backends and the chain follow the plan between frames, never during one
+    if (configured_generation != plan->generation) {
+        preprocessing = PreprocessingPipeline(plan->preprocessing_stages, plan->preprocessing_device, plan->denoise);
+        if (preprocessing.getDevice() != plan->preprocessing_device) {
+            BARCODE_LOG_WARNING("No OpenCL device available, preprocessing runs on the CPU");
+        }
+        preprocessing.setInstrumentation(instrumentation());
+        for (auto& backend : backends) {
+            if (backend) backend->configure(*plan);
+        }
+        configured_generation = plan->generation;
+    }
+    return *plan;
 }
 
 const std::vector<BarcodeResult>& BarcodeScanner::getLastScanResults() const {
     return last_scan_results;
 }
 
-SymbologyType BarcodeScanner::convertZXingFormat(ZXing::BarcodeFormat format) {
-    switch (format) {
-        case ZXing::BarcodeFormat::QRCode:
-            return SymbologyType::QRCode;
-        case ZXing::BarcodeFormat::DataMatrix:
-            return SymbologyType::DataMatrix;
-        case ZXing::BarcodeFormat::Aztec:
-            return SymbologyType::Aztec;
-        case ZXing::BarcodeFormat::PDF417:
-            return SymbologyType::PDF417;
-        case ZXing::BarcodeFormat::EAN13:
-            return SymbologyType::EAN13;
-        case ZXing::BarcodeFormat::EAN8:
-            return SymbologyType::EAN8;
-        case ZXing::BarcodeFormat::UPCA:
-            return SymbologyType::UPCA;
-        case ZXing::BarcodeFormat::UPCE:
-            return SymbologyType::UPCE;
-        case ZXing::BarcodeFormat::Code39:
-            return SymbologyType::Code39;
-        case ZXing::BarcodeFormat::Code93:
-            return SymbologyType::Code93;
-        case ZXing::BarcodeFormat::Code128:
-            return SymbologyType::Code128;
-        default:
-            return SymbologyType::None;
-    }
+size_t BarcodeScanner::getPeakWorkspaceBytes() const {
+    return peak_workspace_bytes;
 }
 
-ZXing::BarcodeFormats BarcodeScanner::createZXingFormats(const std::set<SymbologyType>& enabled_symbologies) {
-    ZXing::BarcodeFormats formats;
-    for (const auto& symbology : enabled_symbologies) {
-        switch (symbology) {
-            case SymbologyType::QRCode:
-                formats |= ZXing::BarcodeFormat::QRCode;
-                break;
-            case SymbologyType::DataMatrix:
-                formats |= ZXing::BarcodeFormat::DataMatrix;
-                break;
-            case SymbologyType::Aztec:
-                formats |= ZXing::BarcodeFormat::Aztec;
-                break;
-            case SymbologyType::PDF417:
-                formats |= ZXing::BarcodeFormat::PDF417;
-                break;
-            case SymbologyType::EAN13:
-                formats |= ZXing::BarcodeFormat::EAN13;
-                break;
-            case SymbologyType::EAN8:
-                formats |= ZXing::BarcodeFormat::EAN8;
-                break;
-            case SymbologyType::UPCA:
-                formats |= ZXing::BarcodeFormat::UPCA;
-                break;
-            case SymbologyType::UPCE:
-                formats |= ZXing::BarcodeFormat::UPCE;
-                break;
-            case SymbologyType::Code39:
-                formats |= ZXing::BarcodeFormat::Code39;
-                break;
-            case SymbologyType::Code93:
-                formats |= ZXing::BarcodeFormat::Code93;
-                break;
-            case SymbologyType::Code128:
-                formats |= ZXing::BarcodeFormat::Code128;
-                break;
-            default:
-                break;
-        }
+ScanStatistics BarcodeScanner::getScanStatistics() const {
+    return metrics->getStatistics();
+}
+
+std::shared_ptr<ScanMetrics> BarcodeScanner::getScanMetrics() const {
+    return metrics;
+}
+
+void BarcodeScanner::setScanMetrics(std::shared_ptr<ScanMetrics> shared_metrics) {
+    if (!shared_metrics) return;
+    metrics = std::move(shared_metrics);
+    preprocessing.setInstrumentation(instrumentation());
+}
+
+void BarcodeScanner::setFrameTraceCallback(FrameTraceCallback callback) {
+    trace_callback = std::move(callback);
+}
+
+void BarcodeScanner::setDecoderBackend(std::unique_ptr<DecoderBackend> backend) {
+    if (!backend) return;
+    DecoderEngine engine = backend->engine();
+    backends[engine] = std::move(backend);
+    configured_generation = 0;  // Configured before the next frame
+}
+
+ScanInstrumentation BarcodeScanner::instrumentation() {
+    return ScanInstrumentation{metrics.get(), frame_tracer};
+}
+
+void BarcodeScanner::updateWorkspacePeak() {
+    size_t frame_bytes = getLumaPlaneBytes(luma_planes) + preprocessing.getBufferBytes() +
+                         buffer_pool.getPeakBytesInUse();
+    buffer_pool.resetPeak();
+    for (auto& worker : tile_workers) {
+        frame_bytes += worker->preprocessing.getBufferBytes() + worker->buffer_pool.getPeakBytesInUse();
+        worker->buffer_pool.resetPeak();
+    }
+    if (frame_bytes > peak_workspace_bytes) {
+        peak_workspace_bytes = frame_bytes;
+        BARCODE_LOG_DEBUG("Scan workspace grew to " << peak_workspace_bytes / 1024 << " KB");
     }
-    return formats;
 }
 
-std::vector<BarcodeResult> BarcodeScanner::processWithColorInversion(const cv::Mat& image) {
-    std::vector<BarcodeResult> results;
+// Tracks from the previous frame of the sequence are checked first, the full
+// frame is only searched when the tracker asks for it
+std::vector<BarcodeResult> BarcodeScanner::processTracked(const cv::Mat& image, const DecoderPlan& plan,
+                                                          FrameDeadline& deadline) {
+    uint64_t sequence_id = context->getFrameSequenceId();
+    if (sequence_id != tracked_sequence_id) {
+        tracker.reset();
+        tracked_sequence_id = sequence_id;
+    }
     
-    // Process normal image
-    auto normal_results = processImage(image, false);
-    results.insert(results.end(), normal_results.begin(), normal_results.end());
+    auto decode_region = [&](const cv::Mat& frame, const cv::Rect& region, std::vector<BarcodeResult>& found) {
+        if (deadline.expired()) {
+            deadline.markExhausted();
+            return false;
+        }
+        for (auto& result : processWithColorInversion(frame(region), cv::Mat(), plan, deadline)) {
+            result.location.x += region.x;
+            result.location.y += region.y;
+            found.push_back(std::move(result));
+        }
+        return true;
+    };
+    auto full_search = [&](const cv::Mat& frame) {
+        return processFullFrame(frame, cv::Mat(), plan, deadline);
+    };
     
-    // Process inverted image if any symbology has color inversion enabled
-    bool any_color_inversion = false;
-    for (int i = 0; i < static_cast<int>(SymbologyType::Aztec) + 1; ++i) {
-        if (settings->isColorInverted(static_cast<SymbologyType>(i))) {
-            any_color_inversion = true;
-            break;
+    auto results = tracker.processFrame(image, plan.max_codes_per_frame, decode_region, full_search);
+    BARCODE_LOG_DEBUG("Tracking " << tracker.size() << " code(s)");
+    return results;
+}
+
+// Re-decodes only the regions the cached codes were at; the frame counts
+// as a hit only if every one of them is read again there
+bool BarcodeScanner::verifyCachedResults(const cv::Mat& image, const std::vector<BarcodeResult>& cached, double margin,
+                                         const DecoderPlan& plan, FrameDeadline& deadline,
+                                         std::vector<BarcodeResult>& results) {
+    results.clear();
+    cv::Rect frame(0, 0, image.cols, image.rows);
+    
+    for (const BarcodeResult& expected : cached) {
+        bool found = false;
+        for (const BarcodeResult& result : results) {
+            if (result.symbology == expected.symbology && result.data == expected.data) found = true;
+        }
+        if (found) continue;
+        
+        if (deadline.expired()) {
+            deadline.markExhausted();
+            return false;
         }
+        const cv::Rect& last = expected.location;
+        int grow = static_cast<int>(std::lround(margin * std::max(last.width, last.height)));
+        cv::Rect region = cv::Rect(last.x - grow, last.y - grow, last.width + 2 * grow, last.height + 2 * grow) & frame;
+        if (region.empty()) return false;
+        
+        for (auto& result : processWithColorInversion(image(region), cv::Mat(), plan, deadline)) {
+            result.location.x += region.x;
+            result.location.y += region.y;
+            if (result.symbology == expected.symbology && result.data == expected.data) found = true;
+            results.push_back(std::move(result));
+        }
+        if (!found) return false;
     }
     
-    if (any_color_inversion) {
-        cv::Mat inverted;
-        cv::bitwise_not(image, inverted);
-        auto inverted_results = processImage(inverted, true);
-        results.insert(results.end(), inverted_results.begin(), inverted_results.end());
+    return true;
+}
+
+std::vector<BarcodeResult> BarcodeScanner::processFullFrame(const cv::Mat& image, const cv::Mat& inverted,
+                                                            const DecoderPlan& plan, FrameDeadline& deadline) {
+    // Process with potential color inversion
+    if (plan.search_whole_image) {
+        std::vector<cv::Rect> tiles = computeTileGrid(image.size(), plan.tiling);
+        if (!tiles.empty()) return processTiles(image, inverted, tiles, plan, deadline);
+        return processWithColorInversion(image, inverted, plan, deadline);
     }
-    
-    return results;
+    return processRegionsOfInterest(image, inverted, plan, deadline);
 }
 
-std::vector<BarcodeResult> BarcodeScanner::processImage(const cv::Mat& image, bool is_inverted) {
-    std::vector<BarcodeResult> results;
+// Every worker is a scanner of its own, with its own backends, chain and
+// pooled buffers that only ever hold one tile, so memory grows with
+// max_workers x tile size rather than with the frame. Workers pull tiles in
+// row order until none are left, the frame has max_codes_per_frame codes or
+// the budget runs out. Codes in the overlap of two tiles are merged with the
+// rest of the frame's results. Workers use the built-in backends, not those
+// given to setDecoderBackend().
+std::vector<BarcodeResult> BarcodeScanner::processTiles(const cv::Mat& image, const cv::Mat& inverted,
+                                                        const std::vector<cv::Rect>& tiles, const DecoderPlan& plan,
+                                                        FrameDeadline& deadline) {
+    size_t worker_count = plan.tiling.max_workers > 0 ? static_cast<size_t>(plan.tiling.max_workers)
+                                                      : std::max(1u, std::thread::hardware_concurrency());
+    worker_count = std::min(worker_count, tiles.size());
+    while (tile_workers.size() < worker_count) {
+        tile_workers.emplace_back(new BarcodeScanner(context, settings));
+    }
+    for (size_t i = 0; i < worker_count; ++i) {
+        prepareTileWorker(*tile_workers[i]);
+    }
+    BARCODE_LOG_DEBUG("Decoding " << tiles.size() << " tiles of " << tiles[0].width << "x" << tiles[0].height
+                      << " on " << worker_count << " worker(s)");
     
-    // ZXing processing
-    ZXing::ImageView view(image.data, image.cols, image.rows, ZXing::ImageFormat::Lum);
-    
-    ZXing::ReaderOptions options;
-    options.setTryHarder(settings->getTryHarderMode());
-    options.setTryRotate(true);
-    options.setMaxNumberOfSymbols(settings->getMaxCodesPerFrame());
-    options.setFormats(createZXingFormats(settings->getEnabledSymbologies()));
-    
-    auto barcodes = ZXing::ReadBarcodes(view, options);
-    
-    for (const auto& barcode : barcodes) {
-        if (barcode.isValid() && !barcode.text().empty()) {
-            BarcodeResult result;
-            result.data = barcode.text();
-            result.symbology = convertZXingFormat(barcode.format());
-            result.symbology_name = getSymbologyName(result.symbology);
-            result.is_color_inverted = is_inverted;
-            result.confidence = 1.0; // ZXing doesn't provide confidence
-            
-            // Parse format-specific details
-            switch (result.symbology) {
-                case SymbologyType::EAN13:
-                case SymbologyType::EAN8:
-                case SymbologyType::UPCA:
-                    result.format_details = parseGTIN(result.data);
-                    break;
-                case SymbologyType::QRCode:
-                    result.format_details = parseQRCode(result.data);
-                    break;
-                case SymbologyType::DataMatrix:
-                    result.format_details = parseDataMatrix(result.data);
-                    break;
-                default:
-                    result.format_details = "Standard format";
+    std::vector<std::vector<BarcodeResult>> tile_results(tiles.size());
+    std::atomic<size_t> next_tile(0);
+    // A code in the overlap of two tiles is found by both, count it once
+    ScanCancellationToken token(plan.max_codes_per_frame);
+    auto run_worker = [&](BarcodeScanner& worker) {
+        for (size_t i = next_tile++; i < tiles.size(); i = next_tile++) {
+            if (token.isCancelled()) break;
+            if (deadline.expired()) {
+                deadline.markExhausted();
+                break;
             }
-            
-            // Get location if available
-            try {
-                auto position = barcode.position();
-                result.location = cv::Rect(
-                    position.topLeft().x,
-                    position.topLeft().y,
-                    position.bottomRight().x - position.topLeft().x,
-                    position.bottomRight().y - position.topLeft().y
-                );
-            } catch (...) {
-                // Fallback if position is not available
-                result.location = cv::Rect(0, 0, image.cols, image.rows);
+            const cv::Rect& tile = tiles[i];
+            tile_results[i] = worker.processWithColorInversion(image(tile), inverted.empty() ? cv::Mat() : inverted(tile),
+                                                               plan, deadline);
+            worker.pyramid.clear();
+            for (auto& result : tile_results[i]) {
+                result.location.x += tile.x;
+                result.location.y += tile.y;
             }
-            
-            results.push_back(result);
+            token.reportFound(tile_results[i]);
         }
-    }
+    };
     
-    // libdmtx processing for DataMatrix (if enabled)
-    if (settings->isSymbologyEnabled(SymbologyType::DataMatrix)) {
-        auto dm_results = processDataMatrix(image, is_inverted);
-        results.insert(results.end(), dm_results.begin(), dm_results.end());
+    std::vector<std::future<void>> workers;
+    // The first worker runs on this thread
+    for (size_t i = 1; i < worker_count; ++i) {
+        BarcodeScanner& worker = *tile_workers[i];
+        workers.push_back(std::async(std::launch::async, [&run_worker, &worker] { run_worker(worker); }));
+    }
+    run_worker(*tile_workers[0]);
+    for (auto& worker : workers) {
+        worker.get();
+    }
+    // Lets the next frame recycle the arena
+    for (size_t i = 0; i < worker_count; ++i) {
+        tile_workers[i]->text_arena.reset();
     }
     
+    // Merged in tile order, so results are reported row by row
+    std::vector<BarcodeResult> results;
+    for (auto& found_in_tile : tile_results) {
+        results.insert(results.end(), std::make_move_iterator(found_in_tile.begin()), std::make_move_iterator(found_in_tile.end()));
+    }
     return results;
 }
 
-std::vector<BarcodeResult> BarcodeScanner::processDataMatrix(const cv::Mat& image, bool is_inverted) {
+void BarcodeScanner::prepareTileWorker(BarcodeScanner& worker) {
+    // Tile spans belong to this frame's trace; addSpan() locks
+    if (worker.frame_tracer != &tracer) {
+        worker.frame_tracer = &tracer;
+        worker.preprocessing.setInstrumentation(worker.instrumentation());
+    }
+    worker.plan = plan;
+    worker.currentPlan();
+    // The tiles already run on one worker per core
+    worker.concurrent_inversion = false;
+    worker.text_arena = text_arena;
+    if (worker.metrics != metrics) worker.setScanMetrics(metrics);
+}
+
+// Only the localiser's candidates reach the decoders; a frame without
+// candidates has no codes
+std::vector<BarcodeResult> BarcodeScanner::processRegionsOfInterest(const cv::Mat& image, const cv::Mat& inverted,
+                                                                    const DecoderPlan& plan, FrameDeadline& deadline) {
     std::vector<BarcodeResult> results;
     
-    DmtxImage* img = dmtxImageCreate(image.data, image.cols, image.rows, DmtxPack8bppK);
-    if (!img) return results;
-    
-    DmtxDecode* dec = dmtxDecodeCreate(img, 1);
-    if (!dec) {
-        dmtxImageDestroy(&img);
-        return results;
+    std::vector<cv::Rect> regions;
+    {
+        ScopedStageTimer localize_timer(instrumentation(), SCAN_STAGE_LOCALIZE);
+        regions = localizer.locate(image);
     }
     
-    DmtxTime timeout = dmtxTimeAdd(dmtxTimeNow(), 2000); // 2 second timeout
-    
-    for (int i = 0; i < 10; i++) {
-        DmtxRegion* reg = dmtxRegionFindNext(dec, &timeout);
-        if (!reg) break;
-        
-        DmtxMessage* msg = dmtxDecodeMatrixRegion(dec, reg, DmtxUndefined);
-        if (msg && msg->output != nullptr && msg->outputSize > 0) {
-            BarcodeResult result;
-            result.data = std::string(reinterpret_cast<char*>(msg->output), msg->outputSize);
-            result.symbology = SymbologyType::DataMatrix;
-            result.symbology_name = "DataMatrix";
-            result.is_color_inverted = is_inverted;
-            result.confidence = 1.0;
-            result.location = cv::Rect(0, 0, image.cols, image.rows);
-            
-            results.push_back(result);
-            dmtxMessageDestroy(&msg);
+    for (const cv::Rect& roi : regions) {
+        if (static_cast<int>(results.size()) >= plan.max_codes_per_frame) break;
+        if (deadline.expired()) {
+            deadline.markExhausted();
+            break;
         }
         
-        dmtxRegionDestroy(&reg);
+        // Decoders read the frame through a view, locations come back region-relative
+        auto region_results = processWithColorInversion(image(roi), inverted.empty() ? cv::Mat() : inverted(roi),
+                                                        plan, deadline);
+        for (auto& result : region_results) {
+            result.location.x += roi.x;
+            result.location.y += roi.y;
+            results.push_back(std::move(result));
+        }
     }
     
-    dmtxDecodeDestroy(&dec);
-    dmtxImageDestroy(&img);
-    
     return results;
 }
 
-std::string BarcodeScanner::parseGTIN(const std::string& data) {
-    if (data.length() < 8) return "Invalid GTIN";
-    
-    std::stringstream ss;
-    ss << "GTIN: " << data << "\n";
-    
-    // Check digit validation
-    int sum = 0;
-    for (size_t i = 0; i < data.length() - 1; i++) {
-        int digit = data[i] - '0';
-        sum += (i % 2 == 0) ? digit * 3 : digit;
+// Below this many pixels handing the inverted pass to another thread costs
+// more than it saves, e.g. for tracked regions and localiser candidates
+static const size_t MIN_CONCURRENT_INVERSION_PIXELS = 320 * 240;
+
+std::vector<BarcodeResult> BarcodeScanner::processWithColorInversion(const cv::Mat& image, const cv::Mat& inverted,
+                                                                     const DecoderPlan& plan, FrameDeadline& deadline) {
+    // ZXing covers both polarities on its own, only the other engines need an inverted copy
+    if (!plan.run_inverted_pass) {
+        return processImage(image, plan, deadline);
     }
-    int checkDigit = (10 - (sum % 10)) % 10;
-    
-    ss << "Check Digit: " << checkDigit << "\n";
-    ss << "Valid: " << (checkDigit == (data.back() - '0') ? "Yes" : "No");
-    
-    return ss.str();
+
+    // The inverted polarity gives up once the frame has max_codes_per_frame codes
+    ScanCancellationToken token(plan.max_codes_per_frame);
+    std::vector<BarcodeResult> results;
+    std::vector<BarcodeResult> inverted_results;
+
+    if (!concurrent_inversion || image.total() < MIN_CONCURRENT_INVERSION_PIXELS) {
+        results = processImage(image, plan, deadline, &token);
+        inverted_results = processInvertedPolarity(image, inverted, plan, deadline, token);
+    } else {
+        if (!inversion_worker) inversion_worker.reset(new ScanTaskWorker());
+        inversion_worker->start([this, &image, &inverted, &plan, &deadline, &token, &inverted_results] {
+            inverted_results = processInvertedPolarity(image, inverted, plan, deadline, token);
+        });
+
+        try {
+            results = processImage(image, plan, deadline, &token);
+        } catch (...) {
+            token.cancel();
+            try {
+                inversion_worker->wait();
+            } catch (...) {
+            }
+            throw;
+        }
+        inversion_worker->wait();
+    }
+
+    results.insert(results.end(), std::make_move_iterator(inverted_results.begin()), std::make_move_iterator(inverted_results.end()));
+    return results;
 }
 
-std::string BarcodeScanner::parseQRCode(const std::string& data) {
-    std::stringstream ss;
-    ss << "QR Code Data:\n";
-    
-    // Try to detect if it's a URL
-    if (data.find("http://") == 0 || data.find("https://") == 0) {
-        ss << "Type: URL\n";
-        ss << "URL: " << data;
+std::vector<BarcodeResult> BarcodeScanner::processInvertedPolarity(const cv::Mat& image, const cv::Mat& inverted,
+                                                                   const DecoderPlan& plan, FrameDeadline& deadline,
+                                                                   ScanCancellationToken& token) {
+    if (token.isCancelled()) return std::vector<BarcodeResult>();
+
+    cv::Mat inverted_image = inverted;
+    FrameBufferPool::Buffer inverted_buffer;
+    if (inverted_image.empty()) {
+        inverted_buffer = buffer_pool.acquire(image.rows, image.cols, image.type());
+        cv::bitwise_not(image, inverted_buffer.mat());
+        inverted_image = inverted_buffer.mat();
+    }
+    return processInvertedImage(inverted_image, plan, deadline, token);
+}
+
+// Engines run in the order the routing table asks for them, so a tight
+// budget still gets the likely hits; fallback engines only run while the
+// frame is still short of max_codes_per_frame. No engine can be
+// interrupted mid-call except libdmtx, so the others are only skipped if the
+// budget is already gone when they would start.
+std::vector<BarcodeResult> BarcodeScanner::processImage(const cv::Mat& image, const DecoderPlan& plan, FrameDeadline& deadline,
+                                                        ScanCancellationToken* token) {
+    std::vector<BarcodeResult> results;
+    std::vector<DecodeCandidate> candidates;
+
+    for (const EngineStep& step : plan.engine_steps) {
+        int found = static_cast<int>(results.size());
+        if (step.fallback && found >= plan.max_codes_per_frame) break;
+        if (token && token->isCancelled()) break;
+        if (deadline.expired()) {
+            deadline.markExhausted();
+            break;
+        }
+
+        std::vector<BarcodeResult> engine_results;
+        if (step.engine == ENGINE_ZXING) {
+            engine_results = processZXingEscalation(image, plan, deadline, candidates, found > 0);
+        } else if (backends[step.engine]) {
+            DecodeRequest request = makeDecodeRequest(image, plan, deadline, token);
+            request.symbologies = plan.engine_symbologies[step.engine];
+            request.max_codes = step.fallback ? plan.max_codes_per_frame - found : plan.max_codes_per_frame;
+            request.candidates = &candidates;
+            backends[step.engine]->decode(request, engine_results);
+        }
+
+        results.insert(results.end(), std::make_move_iterator(engine_results.begin()), std::make_move_iterator(engine_results.end()));
+        // Every engine and scale tends to find the same codes, count them once
+        mergeDuplicateResults(results);
+        if (token) token->reportFound(results);
     }
-    // Try to detect if it's a vCard
-    else if (data.find("BEGIN:VCARD") != std::string::npos) {
-        ss << "Type: vCard\n";
-        // Parse vCard fields
-        std::istringstream iss(data);
-        std::string line;
-        while (std::getline(iss, line)) {
-            if (line.find("FN:") == 0) ss << "Name: " << line.substr(3) << "\n";
-            else if (line.find("TEL:") == 0) ss << "Phone: " << line.substr(4) << "\n";
-            else if (line.find("EMAIL:") == 0) ss << "Email: " << line.substr(6) << "\n";
+
+    return results;
+}
+
+// The engines that cannot invert on their own, over the inverted image,
+// for the symbologies with color inversion on
+std::vector<BarcodeResult> BarcodeScanner::processInvertedImage(const cv::Mat& inverted, const DecoderPlan& plan,
+                                                                FrameDeadline& deadline, ScanCancellationToken& token) {
+    std::vector<BarcodeResult> results;
+
+    for (const EngineStep& step : plan.engine_steps) {
+        if (!plan.inverted_symbologies[step.engine] || !backends[step.engine]) continue;
+        if (token.isCancelled()) break;
+        if (deadline.expired()) {
+            deadline.markExhausted();
+            break;
         }
+
+        DecodeRequest request = makeDecodeRequest(inverted, plan, deadline, &token);
+        request.symbologies = plan.inverted_symbologies[step.engine];
+        request.is_inverted = true;
+        std::vector<BarcodeResult> engine_results;
+        backends[step.engine]->decode(request, engine_results);
+        token.reportFound(engine_results);
+        results.insert(results.end(), std::make_move_iterator(engine_results.begin()), std::make_move_iterator(engine_results.end()));
     }
-    // Try to detect if it's a WiFi configuration
-    else if (data.find("WIFI:") == 0) {
-        ss << "Type: WiFi Configuration\n";
-        // Parse WiFi fields
-        std::istringstream iss(data);
-        std::string line;
-        while (std::getline(iss, line, ';')) {
-            if (line.find("S:") == 0) ss << "SSID: " << line.substr(2) << "\n";
-            else if (line.find("T:") == 0) ss << "Security: " << line.substr(2) << "\n";
-            else if (line.find("P:") == 0) ss << "Password: " << line.substr(2) << "\n";
+
+    return results;
+}
+
+DecodeRequest BarcodeScanner::makeDecodeRequest(const cv::Mat& image, const DecoderPlan& plan, FrameDeadline& deadline,
+                                                ScanCancellationToken* token) {
+    DecodeRequest request;
+    request.image = image;
+    request.to_frame = 1.0;
+    request.symbologies = 0;
+    request.is_inverted = false;
+    request.max_codes = plan.max_codes_per_frame;
+    request.plan = &plan;
+    request.deadline = &deadline;
+    request.token = token;
+    request.candidates = nullptr;
+    request.buffers = &buffer_pool;
+    request.text = text_arena;
+    request.instrumentation = instrumentation();
+    return request;
+}
+
+// One ZXing read; to_frame maps positions in image back to the frame
+std::vector<BarcodeResult> BarcodeScanner::processZXing(const cv::Mat& image, double to_frame, const DecoderPlan& plan,
+                                                        FrameDeadline& deadline, std::vector<DecodeCandidate>& candidates) {
+    DecodeRequest request = makeDecodeRequest(image, plan, deadline, nullptr);
+    request.to_frame = to_frame;
+    request.symbologies = plan.engine_symbologies[ENGINE_ZXING];
+    request.candidates = &candidates;
+
+    std::vector<BarcodeResult> results;
+    backends[ENGINE_ZXING]->decode(request, results);
+    return results;
+}
+
+// Decode order of the escalation policy: ZXing on the raw gray image, then
+// the configured preprocessing chain only if that found nothing
+std::vector<BarcodeResult> BarcodeScanner::processZXingEscalation(const cv::Mat& image, const DecoderPlan& plan,
+                                                                  FrameDeadline& deadline,
+                                                                  std::vector<DecodeCandidate>& candidates,
+                                                                  bool found_earlier) {
+    std::vector<BarcodeResult> results;
+    bool run_chain = !preprocessing.empty();
+
+    if (plan.escalate_preprocessing || preprocessing.empty()) {
+        results = processZXingDirect(image, plan, deadline, candidates);
+        run_chain = run_chain && !found_earlier && results.empty();
+    }
+    if (!run_chain) return results;
+
+    if (deadline.expired()) {
+        deadline.markExhausted();
+        return results;
+    }
+    auto chain_results = processZXingScales(image, plan, deadline, candidates);
+    results.insert(results.end(), std::make_move_iterator(chain_results.begin()), std::make_move_iterator(chain_results.end()));
+    return results;
+}
+
+// ZXing on the gray image itself. A whole frame whose codes are coarse
+// enough goes through a {0.5, 1.0} pyramid whose first level is the luma
+// pass's half plane, so it costs no resize; full size runs only if half
+// size found nothing.
+std::vector<BarcodeResult> BarcodeScanner::processZXingDirect(const cv::Mat& image, const DecoderPlan& plan,
+                                                              FrameDeadline& deadline,
+                                                              std::vector<DecodeCandidate>& candidates) {
+    bool whole_frame = !luma_planes.half.empty() && image.data == luma_planes.luma.data &&
+                       image.size() == luma_planes.luma.size();
+    if (!whole_frame) return processZXing(image, 1.0, plan, deadline, candidates);
+
+    double module_size = estimateFrameModuleSize(image, image, 1.0, plan);
+    if (module_size < 2.0 * multi_scale_options.target_module_px) {
+        return processZXing(image, 1.0, plan, deadline, candidates);
+    }
+
+    pyramid.reset(image, {0.5, 1.0}, luma_planes.half);
+    std::vector<BarcodeResult> results = processZXing(pyramid.level(0), 1.0 / pyramid.scale(0), plan, deadline, candidates);
+    if (!results.empty()) {
+        BARCODE_LOG_DEBUG("Module size " << module_size << " px, decoded at half size");
+        return results;
+    }
+    if (deadline.expired()) {
+        deadline.markExhausted();
+        return results;
+    }
+    return processZXing(pyramid.level(1), 1.0, plan, deadline, candidates);
+}
+
+// Preprocessing chain followed by ZXing over a pyramid of the cleaned
+// image. The best scale runs first and ends the loop if it finds enough
+// codes; otherwise every remaining scale is needed, so they run in parallel.
+std::vector<BarcodeResult> BarcodeScanner::processZXingScales(const cv::Mat& image, const DecoderPlan& plan,
+                                                              FrameDeadline& deadline,
+                                                              std::vector<DecodeCandidate>& candidates) {
+    const cv::Mat& cleaned = preprocessing.run(image);
+    pyramid.reset(cleaned, selectScales(image, cleaned, plan));
+
+    std::vector<BarcodeResult> results;
+    if (pyramid.size() == 0) return results;
+    results = processPyramidLevel(0, plan, deadline, candidates);
+    if (static_cast<int>(results.size()) >= plan.max_codes_per_frame) {
+        BARCODE_LOG_DEBUG("Enough codes at scale " << pyramid.scale(0) << ", skipping the other scales");
+        return results;
+    }
+
+    auto level_expired = [&deadline] {
+        if (!deadline.expired()) return false;
+        deadline.markExhausted();
+        return true;
+    };
+
+    size_t remaining = pyramid.size() - 1;
+    std::vector<std::vector<DecodeCandidate>> level_candidates(remaining);
+    std::vector<std::future<std::vector<BarcodeResult>>> levels;
+    // The last level is decoded on this thread
+    for (size_t i = 1; i < remaining && !level_expired(); ++i) {
+        levels.push_back(std::async(std::launch::async, [this, i, &plan, &deadline, &level_candidates, &level_expired] {
+            if (level_expired()) return std::vector<BarcodeResult>();
+            return processPyramidLevel(i, plan, deadline, level_candidates[i - 1]);
+        }));
+    }
+    std::vector<BarcodeResult> last_results;
+    if (remaining > 0 && !level_expired()) {
+        last_results = processPyramidLevel(remaining, plan, deadline, level_candidates[remaining - 1]);
+    }
+
+    // Merged in scale order, best first
+    for (auto& level : levels) {
+        auto level_results = level.get();
+        results.insert(results.end(), std::make_move_iterator(level_results.begin()), std::make_move_iterator(level_results.end()));
+    }
+    results.insert(results.end(), std::make_move_iterator(last_results.begin()), std::make_move_iterator(last_results.end()));
+    for (const auto& found : level_candidates) {
+        candidates.insert(candidates.end(), found.begin(), found.end());
+    }
+
+    return results;
+}
+
+// Scales for this image from the module size inside the localiser's
+// candidates
+std::vector<double> BarcodeScanner::selectScales(const cv::Mat& image, const cv::Mat& cleaned, const DecoderPlan& plan) {
+    double module_size = estimateFrameModuleSize(image, cleaned, preprocessing.getScaleFactor(), plan);
+    std::vector<double> scales = selectPyramidScales(module_size, multi_scale_options);
+    BARCODE_LOG_DEBUG("Estimated module size " << module_size << " px, decoding " << scales.size() << " scale(s)");
+    return scales;
+}
+
+// Module size in pixels of cleaned, which is image scaled by chain_scale;
+// a region-of-interest crop is its own candidate
+double BarcodeScanner::estimateFrameModuleSize(const cv::Mat& image, const cv::Mat& cleaned, double chain_scale,
+                                               const DecoderPlan& plan) {
+    std::vector<cv::Rect> regions;
+    if (plan.search_whole_image) {
+        std::vector<cv::Rect> located;
+        {
+            ScopedStageTimer localize_timer(instrumentation(), SCAN_STAGE_LOCALIZE);
+            located = localizer.locate(image);
+        }
+        for (const cv::Rect& region : located) {
+            regions.push_back(cv::Rect(cvRound(region.x * chain_scale), cvRound(region.y * chain_scale),
+                                       cvRound(region.width * chain_scale), cvRound(region.height * chain_scale)));
         }
+    } else {
+        regions.push_back(cv::Rect(0, 0, cleaned.cols, cleaned.rows));
     }
-    else {
-        ss << "Type: Text\n";
-        ss << "Content: " << data;
+
+    return estimateModuleSize(cleaned, regions, multi_scale_options.scanlines_per_region);
+}
+
+// Safe to call for distinct levels from several threads
+std::vector<BarcodeResult> BarcodeScanner::processPyramidLevel(size_t index, const DecoderPlan& plan, FrameDeadline& deadline,
+                                                               std::vector<DecodeCandidate>& candidates) {
+    // The chain may upscale before the scale is applied
+    double to_frame = 1.0 / (preprocessing.getScaleFactor() * pyramid.scale(index));
+    return processZXing(pyramid.level(index), to_frame, plan, deadline, candidates);
+}
+
+bool BarcodeResult::gtin(GtinView& view) const {
+    switch (symbology) {
+        case SymbologyType::EAN:
+        case SymbologyType::EAN13:
+        case SymbologyType::EAN8:
+        case SymbologyType::UPCA:
+            return parseGtin(data, view);
+        default: {
+            std::string_view digits;
+            return findGs1Element(data, "01", digits) && parseGtin(digits, view);
+        }
     }
-    
-    return ss.str();
 }
 
-std::string BarcodeScanner::parseDataMatrix(const std::string& data) {
-    std::stringstream ss;
-    ss << "DataMatrix Content:\n";
+Gs1Tokenizer BarcodeResult::gs1() const {
+    return Gs1Tokenizer(data);
+}
+
+bool BarcodeResult::wifi(WifiView& view) const {
+    return parseWifi(data, view);
+}
+
+bool BarcodeResult::vcard(VCardView& view) const {
+    return parseVCard(data, view);
+}
+
+PayloadKind BarcodeResult::payloadKind() const {
+    return detectPayloadKind(data);
+}
+
+std::string BarcodeResult::formatDetails() const {
+    std::string details;
+    
+    if (symbology == SymbologyType::EAN13 || symbology == SymbologyType::EAN8 || symbology == SymbologyType::UPCA) {
+        GtinView view;
+        if (!gtin(view)) return "Invalid GTIN";
+        details.append("GTIN: ").append(view.digits);
+        details.append("\nCheck Digit: ").append(1, static_cast<char>('0' + view.expected_check_digit));
+        details.append("\nValid: ").append(view.check_digit_valid ? "Yes" : "No");
+        return details;
+    }
+    
+    if (symbology == SymbologyType::QRCode) details = "QR Code Data:\n";
+    else if (symbology == SymbologyType::DataMatrix) details = "DataMatrix Content:\n";
     
-    // Try to detect if it's a GS1 format
-    if (data.find("(01)") == 0 || data.find("(10)") == 0 || data.find("(21)") == 0) {
-        ss << "Type: GS1\n";
-        // Parse GS1 fields
-        std::istringstream iss(data);
-        std::string line;
-        while (std::getline(iss, line, '(')) {
-            if (line.empty()) continue;
-            size_t end = line.find(')');
-            if (end != std::string::npos) {
-                std::string ai = line.substr(0, end);
-                std::string value = line.substr(end + 1);
-                ss << "AI " << ai << ": " << value << "\n";
+    switch (payloadKind()) {
+        case PAYLOAD_GS1: {
+            details += "Type: GS1\n";
+            Gs1Tokenizer tokenizer = gs1();
+            Gs1Element element;
+            while (tokenizer.next(element)) {
+                details.append("AI ").append(element.ai).append(": ").append(element.value).append("\n");
             }
+            return details;
         }
+        case PAYLOAD_URL:
+            return details.append("Type: URL\nURL: ").append(data);
+        case PAYLOAD_VCARD: {
+            VCardView view;
+            vcard(view);
+            details += "Type: vCard\n";
+            if (!view.name.empty()) details.append("Name: ").append(view.name).append("\n");
+            if (!view.phone.empty()) details.append("Phone: ").append(view.phone).append("\n");
+            if (!view.email.empty()) details.append("Email: ").append(view.email).append("\n");
+            return details;
+        }
+        case PAYLOAD_WIFI: {
+            WifiView view;
+            wifi(view);
+            details += "Type: WiFi Configuration\n";
+            details.append("SSID: ").append(view.ssid).append("\n");
+            details.append("Security: ").append(view.security).append("\n");
+            details.append("Password: ").append(view.password).append("\n");
+            return details;
+        }
+        case PAYLOAD_TEXT:
+        default:
+            if (details.empty()) return "Standard format";
+            return details.append("Type: Text\nContent: ").append(data);
     }
-    else {
-        ss << "Type: Raw Data\n";
-        ss << "Content: " << data;
-    }
-    
-    return ss.str();
 }
 
-std::string BarcodeScanner::getSymbologyName(SymbologyType symbology) const {
+std::string_view getSymbologyName(SymbologyType symbology) {
     switch (symbology) {
         case SymbologyType::QRCode: return "QR";
         case SymbologyType::DataMatrix: return "DataMatrix";
@@ -475,35 +1292,41 @@ std::string BarcodeScanner::getSymbologyName(SymbologyType symbology) const {
     }
 }
 
+const char* getScanStatusName(ScanStatus status) {
+    switch (status) {
+        case SCAN_SUCCESS: return "SUCCESS";
+        case SCAN_NO_CODES_FOUND: return "NO_CODES_FOUND";
+        case SCAN_PROCESSING_ERROR: return "PROCESSING_ERROR";
+        case SCAN_INVALID_IMAGE: return "INVALID_IMAGE";
+        case SCAN_PARTIAL_BUDGET_EXHAUSTED: return "PARTIAL_BUDGET_EXHAUSTED";
+        default: return "UNKNOWN";
+    }
+}
+
 // Implementations for factory functions
 std::shared_ptr<RecognitionContext> createRecognitionContext() {
     return std::make_shared<RecognitionContext>();
 }
 
 std::shared_ptr<BarcodeScannerSettings> createScannerSettings(ScanPreset preset) {
-    return std::make_shared<BarcodeScannerSettings>();
+    return std::make_shared<BarcodeScannerSettings>(preset);
 }
 
 void configureScannerForShippingLabels(std::shared_ptr<BarcodeScannerSettings> settings) {
-    std::cout << "\n=== CONFIGURING SCANNER FOR SHIPPING LABELS ===" << std::endl;
+    BARCODE_LOG_INFO("\n=== CONFIGURING SCANNER FOR SHIPPING LABELS ===");
     
     // Enable symbologies commonly found on shipping labels
-    settings->setSymbologyEnabled(SymbologyType::Code128, true);
-    settings->setSymbologyEnabled(SymbologyType::Code39, true);
-    settings->setSymbologyEnabled(SymbologyType::EAN, true);
-    settings->setSymbologyEnabled(SymbologyType::DataMatrix, true);
-    settings->setSymbologyEnabled(SymbologyType::QRCode, true);
+    settings->setEnabledSymbologyMask(settings->getEnabledSymbologyMask() | SHIPPING_LABEL_SYMBOLOGIES);
     
     // Enable color inversion for problematic barcodes
-    settings->setColorInvertedEnabled(SymbologyType::Code128, true);
-    settings->setColorInvertedEnabled(SymbologyType::EAN, true);
+    settings->setColorInvertedMask(settings->getColorInvertedMask() | SHIPPING_LABEL_INVERTED_SYMBOLOGIES);
     
     // Configure for single frame processing
     settings->setMaxCodesPerFrame(10);
     settings->setSearchWholeImage(true);
     settings->setTryHarderMode(true);
     
-    std::cout << "Scanner configured for shipping label processing" << std::endl;
+    BARCODE_LOG_INFO("Scanner configured for shipping label processing");
 }
 
 ImageDescription createImageDescription(const cv::Mat& opencv_image) {
@@ -511,12 +1334,51 @@ ImageDescription createImageDescription(const cv::Mat& opencv_image) {
     desc.width = opencv_image.cols;
     desc.height = opencv_image.rows;
     desc.channels = opencv_image.channels();
-    desc.row_bytes = desc.channels * desc.width;
-    desc.memory_size = desc.width * desc.height * desc.channels;
-    desc.image_data = opencv_image.clone();
+    desc.row_bytes = static_cast<int>(opencv_image.step);
+    desc.memory_size = static_cast<size_t>(desc.row_bytes) * desc.height;
+    desc.pixel_format = desc.channels == 4 ? PIXEL_FORMAT_BGRA
+                      : desc.channels == 3 ? PIXEL_FORMAT_BGR
+                      : PIXEL_FORMAT_GRAY;
+    desc.is_view = false;
+    desc.image_data = opencv_image;  // Shares the buffer, the Mat's refcount keeps it alive
+    
+    BARCODE_LOG_DEBUG("Image description created: " << desc.width << "x" << desc.height 
+             << " (" << desc.channels << " channels, " << desc.memory_size << " bytes)");
+    
+    return desc;
+}
+
+ImageDescription createImageDescriptionView(const uint8_t* pixels, int width, int height, int row_bytes, PixelFormat format) {
+    ImageDescription desc;
+    desc.width = width;
+    desc.height = height;
+    desc.pixel_format = format;
+    desc.is_view = true;
+    
+    int type;
+    switch (format) {
+        case PIXEL_FORMAT_BGR:  desc.channels = 3; type = CV_8UC3; break;
+        case PIXEL_FORMAT_BGRA: desc.channels = 4; type = CV_8UC4; break;
+        case PIXEL_FORMAT_YUYV: desc.channels = 2; type = CV_8UC2; break;
+        case PIXEL_FORMAT_GRAY:
+        case PIXEL_FORMAT_NV12:
+        default:                desc.channels = 1; type = CV_8UC1; break;
+    }
     
-    std::cout << "Image description created: " << desc.width << "x" << desc.height 
-             << " (" << desc.channels << " channels, " << desc.memory_size << " bytes)" << std::endl;
+    desc.row_bytes = row_bytes > 0 ? row_bytes : width * desc.channels;
+    desc.memory_size = static_cast<size_t>(desc.row_bytes) * height;
+    
+    // A stride shorter than one row cannot describe the buffer; cv::Mat
+    // would throw, so the description is left without image data instead
+    if (row_bytes < 0 || (row_bytes > 0 && row_bytes < width * desc.channels)) {
+        BARCODE_LOG_WARNING("Error: row_bytes " << row_bytes << " is shorter than a row of " << width << " pixels");
+        return desc;
+    }
+    
+    if (pixels && width > 0 && height > 0) {
+        // For NV12 this covers just the Y plane at the start of the buffer
+        desc.image_data = cv::Mat(height, width, type, const_cast<uint8_t*>(pixels), desc.row_bytes);
+    }
     
     return desc;
-} 
\ No newline at end of file
+}
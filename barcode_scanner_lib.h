@@ -6,6 +6,15 @@
 #include <memory>
 #include <set>
 #include <map>
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <string_view>
 
 #include <opencv2/opencv.hpp>
 
@@ -13,16 +22,26 @@
 #include <ZXing/ReadBarcode.h>
 #include <ZXing/Flags.h>
 
-extern "C" {
-#include <dmtx.h>
-}
+#include "barcode_buffer_pool.h"
+#include "barcode_localizer.h"
+#include "barcode_luma.h"
+#include "barcode_metrics.h"
+#include "barcode_payload.h"
+#include "barcode_preprocessing.h"
+#include "barcode_pyramid.h"
+#include "barcode_result_cache.h"
+#include "barcode_result_dedup.h"
+#include "barcode_text_arena.h"
+#include "barcode_tiling.h"
+#include "barcode_tracker.h"
 
 // Scandit-style enums and structures (duplicate from scan_main.cpp for now, will remove from main later)
 enum ScanStatus {
     SCAN_SUCCESS = 0,
     SCAN_NO_CODES_FOUND = 1,
     SCAN_PROCESSING_ERROR = 2,
-    SCAN_INVALID_IMAGE = 3
+    SCAN_INVALID_IMAGE = 3,
+    SCAN_PARTIAL_BUDGET_EXHAUSTED = 4  // Frame budget ran out, results may be incomplete
 };
 
 enum ScanPreset {
@@ -47,56 +66,294 @@ enum class SymbologyType {
     Aztec
 };
 
+constexpr int SYMBOLOGY_COUNT = static_cast<int>(SymbologyType::Aztec) + 1;
+
+// Flat bitmask with one bit per SymbologyType
+using SymbologyMask = uint32_t;
+
+constexpr SymbologyMask symbologyBit(SymbologyType symbology) {
+    return SymbologyMask(1) << static_cast<int>(symbology);
+}
+
+// Stable name used in results and logs, e.g. "Code128"
+std::string_view getSymbologyName(SymbologyType symbology);
+
+// Symbology sets of the built-in presets, fixed at compile time
+constexpr SymbologyMask SHIPPING_LABEL_SYMBOLOGIES =
+    symbologyBit(SymbologyType::Code128) | symbologyBit(SymbologyType::Code39) | symbologyBit(SymbologyType::EAN) |
+    symbologyBit(SymbologyType::DataMatrix) | symbologyBit(SymbologyType::QRCode);
+constexpr SymbologyMask SHIPPING_LABEL_INVERTED_SYMBOLOGIES =
+    symbologyBit(SymbologyType::Code128) | symbologyBit(SymbologyType::EAN);
+constexpr SymbologyMask LOW_RESOLUTION_SYMBOLOGIES =
+    symbologyBit(SymbologyType::Code128) | symbologyBit(SymbologyType::Code39) | symbologyBit(SymbologyType::EAN13) |
+    symbologyBit(SymbologyType::EAN8) | symbologyBit(SymbologyType::UPCA) | symbologyBit(SymbologyType::DataMatrix) |
+    symbologyBit(SymbologyType::QRCode);
+
+// Decoders a symbology can be routed to, in the order processImage() runs
+// them when the routes do not say otherwise (cheapest first). Each has a
+// DecoderBackend, see barcode_decoder_backend.h.
+enum DecoderEngine {
+    ENGINE_ZBAR,     // 1D symbologies only, needs BARCODE_HAVE_ZBAR
+    ENGINE_ZXING,
+    ENGINE_LIBDMTX,  // DataMatrix only
+    ENGINE_COUNT
+};
+
+// Engines for one symbology, most preferred first. The first engine always
+// runs; the later ones are fallbacks that only run while the frame is still
+// short of max_codes_per_frame.
+using EngineRoute = std::vector<DecoderEngine>;
+
+const char* getEngineName(DecoderEngine engine);
+// Symbologies the engine decodes; none when it was not compiled in
+SymbologyMask getEngineSymbologies(DecoderEngine engine);
+// ZXing retries the inverted bitmap itself, the others need an inverted pass
+bool engineDecodesInverted(DecoderEngine engine);
+EngineRoute defaultEngineRoute(SymbologyType symbology);
+
+// Text fields are views into the text arena of the frame the result came
+// from. Every copy holds a reference to that arena, so the views stay valid
+// for as long as the result exists; convert to std::string to keep the text
+// beyond that.
 struct BarcodeResult {
-    std::string data;
-    std::string symbology_name;
+    std::string_view data;
+    std::string_view symbology_name;  // Static constant
     SymbologyType symbology;
     cv::Rect location;
     double confidence;
     bool is_color_inverted;
-    std::string format_details;  // Additional format-specific details
-    std::string error_correction;  // Error correction level if applicable
-    std::string raw_data;  // Raw data before parsing
+    std::string_view error_correction;  // Error correction level if applicable
+    std::string_view raw_data;  // Raw data before parsing
+    std::shared_ptr<const BarcodeTextArena> storage;  // Owns the text above
+    
+    // Typed views over data, parsed on each call without allocating, so
+    // consumers that only read data pay nothing. Each returns false when
+    // the payload is not of that kind.
+    bool gtin(GtinView& view) const;  // EAN/UPC payloads, or GS1 AI 01
+    Gs1Tokenizer gs1() const;
+    bool wifi(WifiView& view) const;
+    bool vcard(VCardView& view) const;
+    PayloadKind payloadKind() const;
+    // Human-readable description of the above, built on demand
+    std::string formatDetails() const;
+};
+
+// Pixel layouts accepted by createImageDescriptionView()
+enum PixelFormat {
+    PIXEL_FORMAT_GRAY = 0,
+    PIXEL_FORMAT_BGR,
+    PIXEL_FORMAT_BGRA,
+    PIXEL_FORMAT_NV12,  // Only the leading Y plane is read, the UV plane is ignored
+    PIXEL_FORMAT_YUYV   // Packed 4:2:2, luma is every second byte
 };
 
+// Buffer lifetime: the scanner reads image_data only while processFrame() is
+// running and never keeps a reference to it afterwards. Every BarcodeResult
+// keeps its own text alive, so a view's buffer may be reused or freed as soon
+// as processFrame() returns.
 struct ImageDescription {
     int width;
     int height;
     int channels;
     int row_bytes;
     size_t memory_size;
+    PixelFormat pixel_format;
+    bool is_view;  // true when image_data wraps caller-owned memory
     cv::Mat image_data;
 };
 
+// One frame at 30 fps
+const std::chrono::microseconds DEFAULT_REALTIME_FRAME_BUDGET(33000);
+
+// One engine of the routing table; a fallback engine is first choice for
+// none of the symbologies routed to it
+struct EngineStep {
+    DecoderEngine engine;
+    bool fallback;
+};
+
+// Immutable snapshot of one settings generation, compiled once so the
+// per-frame path does no map lookups or allocations
+struct DecoderPlan {
+    uint64_t generation;
+    uint64_t plan_id;  // Unique in the process; copies of a settings object share it until one changes
+    SymbologyMask enabled_symbologies;
+    SymbologyMask color_inverted_symbologies;
+    SymbologyMask engine_symbologies[ENGINE_COUNT];    // Routed to each engine
+    SymbologyMask inverted_symbologies[ENGINE_COUNT];  // The subset each engine gets in the inverted pass
+    std::vector<EngineStep> engine_steps;  // Routed engines in run order
+    bool run_inverted_pass;  // Some engine needs an inverted copy of the image
+    ZXing::BarcodeFormats zxing_formats;
+    ZXing::ReaderOptions zxing_options;  // Includes TryInvert when any inversion is enabled
+    std::vector<PreprocessStage> preprocessing_stages;
+    bool escalate_preprocessing;
+    PreprocessDevice preprocessing_device;
+    DenoiseOptions denoise;
+    TilingOptions tiling;
+    int max_codes_per_frame;
+    bool search_whole_image;  // Otherwise only the localiser's candidate regions are decoded
+    std::chrono::microseconds frame_budget;  // Zero means unlimited
+    bool temporal_tracking;  // Frames of a sequence reuse the previous frame's codes
+};
+
+// Time budget for one frame, shared by every engine working on it. Engines
+// check it before starting and libdmtx bounds its region search by it.
+class FrameDeadline {
+public:
+    explicit FrameDeadline(std::chrono::microseconds budget);
+    bool isUnlimited() const;
+    bool expired() const;
+    std::chrono::microseconds remaining() const;
+    // Called by an engine that was skipped or cut short
+    void markExhausted();
+    bool wasExhausted() const;
+
+private:
+    std::chrono::steady_clock::time_point deadline;
+    bool unlimited;
+    std::atomic<bool> exhausted;
+};
+
+// Shared by the normal and inverted passes of one frame. The inverted pass
+// polls it and stops once the frame has enough distinct codes; a code that
+// several engines or both polarities report counts once.
+class ScanCancellationToken {
+public:
+    explicit ScanCancellationToken(int target_codes);
+    void reportFound(const BarcodeResult& result);
+    void reportFound(const std::vector<BarcodeResult>& results);
+    void cancel();
+    bool isCancelled() const;
+
+private:
+    std::mutex seen_mutex;
+    BarcodeResultMerger<BarcodeResult> seen;
+    std::atomic<int> found_codes;
+    std::atomic<bool> cancelled;
+    int target_codes;
+};
+
+// One long-lived thread that runs one task at a time, so a scanner's
+// concurrent inverted pass costs a hand-off per call rather than a new
+// thread. The thread starts with the first task.
+class ScanTaskWorker {
+public:
+    ScanTaskWorker();
+    ~ScanTaskWorker();
+
+    ScanTaskWorker(const ScanTaskWorker&) = delete;
+    ScanTaskWorker& operator=(const ScanTaskWorker&) = delete;
+
+    // Runs task on the worker thread; wait() must be called before the next start()
+    void start(std::function<void()> task);
+    // Blocks until the task returned, and rethrows what it threw
+    void wait();
+
+private:
+    void run();
+
+    std::mutex mutex;
+    std::condition_variable task_ready;
+    std::condition_variable task_done;
+    std::function<void()> task;
+    std::exception_ptr failure;
+    bool busy;
+    bool stopping;
+    std::thread thread;
+};
+
 // Scandit-style scanner settings class
 class BarcodeScannerSettings {
 private:
-    std::map<SymbologyType, bool> enabled_symbologies;
-    std::map<SymbologyType, bool> color_inverted;
+    SymbologyMask enabled_symbologies;
+    SymbologyMask color_inverted;
     int max_codes_per_frame;
     bool search_whole_image;
     bool try_harder_mode;
+    std::chrono::microseconds frame_budget;
+    bool temporal_tracking;
+    std::vector<PreprocessStage> preprocessing_stages;
+    bool escalate_preprocessing;
+    PreprocessDevice preprocessing_device;
+    DenoiseOptions denoise;
+    TilingOptions tiling;
+    EngineRoute engine_routes[SYMBOLOGY_COUNT];
+    ScanPreset preset_mode;
+    uint64_t generation;  // Bumped whenever a setter changes a value
+    uint64_t plan_id;     // Replaced with a process-wide unique id on every change
+
+    void markChanged();
 
 public:
-    BarcodeScannerSettings();
+    // PRESET_REALTIME_MODE starts with DEFAULT_REALTIME_FRAME_BUDGET and
+    // temporal tracking on
+    explicit BarcodeScannerSettings(ScanPreset preset = PRESET_SINGLE_FRAME_MODE);
     void setSymbologyEnabled(SymbologyType symbology, bool enabled);
     void setColorInvertedEnabled(SymbologyType symbology, bool enabled);
+    // Replace the whole set at once, e.g. with a preset's constant
+    void setEnabledSymbologyMask(SymbologyMask symbologies);
+    void setColorInvertedMask(SymbologyMask symbologies);
     void setMaxCodesPerFrame(int max_codes);
+    // On by default; off decodes only the regions BarcodeLocalizer finds
     void setSearchWholeImage(bool search);
     void setTryHarderMode(bool try_harder);
+    // Zero disables the budget; otherwise engines that do not fit are skipped
+    // and processFrame() returns SCAN_PARTIAL_BUDGET_EXHAUSTED
+    void setFrameBudget(std::chrono::microseconds budget);
+    // Tracks codes across the frames of one sequence so that stable codes are
+    // re-verified in their predicted region, or skipped, instead of being
+    // searched for in the whole frame again. Only useful when consecutive
+    // frames come from the same camera.
+    void setTemporalTrackingEnabled(bool enabled);
+    // Stages ZXing's low-resolution path runs, in the given order, before
+    // decoding a pyramid of the result. Empty (the default) decodes the gray
+    // frame only.
+    void setPreprocessingStages(const std::vector<PreprocessStage>& stages);
+    // When enabled (the default) the raw gray frame is decoded first and the
+    // preprocessing stages only run if that cheap pass finds nothing
+    void setPreprocessingEscalation(bool enabled);
+    // Runs the preprocessing stages on the CPU (the default) or on the
+    // OpenCL device; scanners fall back to the CPU without one
+    void setPreprocessingDevice(PreprocessDevice device);
+    // Filter and noise threshold of the PREPROCESS_DENOISE stage, see
+    // defaultDenoiseOptions()
+    void setDenoiseOptions(const DenoiseOptions& options);
+    // Splits whole-image frames larger than one tile into overlapping tiles
+    // decoded in parallel (see barcode_tiling.h), for large flatbed scans;
+    // off while expected_symbol_size is 0, the default
+    void setTiling(const TilingOptions& options);
+    // Engines that decode symbology, preferred first. Engines that cannot
+    // read it, or were not compiled in, are dropped; an empty route restores
+    // defaultEngineRoute().
+    void setEngineRoute(SymbologyType symbology, const EngineRoute& route);
     std::set<SymbologyType> getEnabledSymbologies() const;
     bool isColorInverted(SymbologyType symbology) const;
     int getMaxCodesPerFrame() const;
     bool getSearchWholeImage() const;
     bool getTryHarderMode() const;
     bool isSymbologyEnabled(SymbologyType symbology) const;
+    std::chrono::microseconds getFrameBudget() const;
+    bool isTemporalTrackingEnabled() const;
+    const std::vector<PreprocessStage>& getPreprocessingStages() const;
+    bool getPreprocessingEscalation() const;
+    PreprocessDevice getPreprocessingDevice() const;
+    const DenoiseOptions& getDenoiseOptions() const;
+    const TilingOptions& getTiling() const;
+    const EngineRoute& getEngineRoute(SymbologyType symbology) const;
+    ScanPreset getPresetMode() const;
+    SymbologyMask getEnabledSymbologyMask() const;
+    SymbologyMask getColorInvertedMask() const;
+    uint64_t getGeneration() const;
+    std::shared_ptr<const DecoderPlan> compileDecoderPlan() const;
 };
 
 // Scandit-style recognition context
 class RecognitionContext {
 private:
-    bool frame_sequence_started;
+    std::atomic<bool> frame_sequence_started;  // Read by every scanner thread sharing the context
+    std::atomic<uint64_t> frame_sequence_id;
     bool initialized;
+    std::unique_ptr<FrameResultCache<BarcodeResult>> result_cache;
     
 public:
     RecognitionContext();
@@ -104,38 +361,145 @@ public:
     bool startNewFrameSequence();
     void endFrameSequence();
     bool isFrameSequenceStarted() const;
+    // Changes with every startNewFrameSequence(); scanners drop their tracks
+    // when it does
+    uint64_t getFrameSequenceId() const;
     bool isInitialized() const;
+    
+    // Lets every scanner sharing the context reuse the results of a recent,
+    // near-identical frame (see barcode_result_cache.h). Not used while
+    // temporal tracking is on. Call before frames are scanned.
+    void enableResultCache(const ResultCacheOptions& options = defaultResultCacheOptions());
+    void disableResultCache();
+    // Null while disabled
+    FrameResultCache<BarcodeResult>* getResultCache() const;
+    ResultCacheStatistics getResultCacheStatistics() const;
 };
 
+class DecoderBackend;
+struct DecodeCandidate;
+struct DecodeRequest;
+
 // Scandit-style barcode scanner
+// A scanner keeps per-frame scratch buffers, so use one instance per thread
+// (see BarcodeScannerPool) rather than sharing it.
 class BarcodeScanner {
 public:
     BarcodeScanner(std::shared_ptr<RecognitionContext> ctx, std::shared_ptr<BarcodeScannerSettings> sett);
+    ~BarcodeScanner();
     bool waitForSetupCompleted();
     ScanStatus processFrame(const ImageDescription& image_desc);
+    // Writes into the caller's vector instead of last_scan_results
+    ScanStatus processFrame(const ImageDescription& image_desc, std::vector<BarcodeResult>& results);
+    // Scans caller-owned pixels through a view that only lives for this call
+    ScanStatus processFrame(const uint8_t* pixels, int width, int height, int row_bytes, PixelFormat format);
     const std::vector<BarcodeResult>& getLastScanResults() const;
+    // Largest scratch memory one frame has needed, luma planes and pooled
+    // images together
+    size_t getPeakWorkspaceBytes() const;
+    
+    // Per-stage latency histograms and frame counters since construction
+    // or the last ScanMetrics::reset()
+    ScanStatistics getScanStatistics() const;
+    std::shared_ptr<ScanMetrics> getScanMetrics() const;
+    // Records into metrics instead, e.g. one instance for a whole pool
+    void setScanMetrics(std::shared_ptr<ScanMetrics> metrics);
+    // On by default: large images decode the inverted polarity on a second
+    // thread. Scanners that already run one per core, like pool workers,
+    // turn it off and decode both polarities in turn.
+    void setConcurrentInversion(bool enabled);
+    // Called after every frame with its stage spans; empty to stop tracing
+    void setFrameTraceCallback(FrameTraceCallback callback);
+    // Replaces the built-in backend for backend->engine(), e.g. with another
+    // build of the same decoder
+    void setDecoderBackend(std::unique_ptr<DecoderBackend> backend);
 
 private:
-    SymbologyType convertZXingFormat(ZXing::BarcodeFormat format); // Needs ZXing::BarcodeFormat declared
-    ZXing::BarcodeFormats createZXingFormats(const std::set<SymbologyType>& enabled_symbologies); // Needs ZXing::BarcodeFormats declared
-    std::vector<BarcodeResult> processWithColorInversion(const cv::Mat& image);
-    std::vector<BarcodeResult> processImage(const cv::Mat& image, bool is_inverted = false);
-    std::vector<BarcodeResult> processDataMatrix(const cv::Mat& image, bool is_inverted = false); // Needs libdmtx types
-    std::string parseGTIN(const std::string& data);
-    std::string parseQRCode(const std::string& data);
-    std::string parseDataMatrix(const std::string& data);
-    std::string getSymbologyName(SymbologyType symbology) const;
+    ScanStatus scanFrame(const ImageDescription& image_desc, std::vector<BarcodeResult>& results);
+    ScanInstrumentation instrumentation();
+    const DecoderPlan& currentPlan();
+    void updateWorkspacePeak();
+    std::vector<BarcodeResult> processTracked(const cv::Mat& image, const DecoderPlan& plan, FrameDeadline& deadline);
+    bool verifyCachedResults(const cv::Mat& image, const std::vector<BarcodeResult>& cached, double margin,
+                             const DecoderPlan& plan, FrameDeadline& deadline, std::vector<BarcodeResult>& results);
+    // inverted is the matching view of the inverted plane, or empty to
+    // have the inverted pass invert image itself
+    std::vector<BarcodeResult> processFullFrame(const cv::Mat& image, const cv::Mat& inverted, const DecoderPlan& plan,
+                                                FrameDeadline& deadline);
+    std::vector<BarcodeResult> processTiles(const cv::Mat& image, const cv::Mat& inverted, const std::vector<cv::Rect>& tiles,
+                                            const DecoderPlan& plan, FrameDeadline& deadline);
+    // Readies a tile worker for this frame's plan, arena, metrics and trace
+    void prepareTileWorker(BarcodeScanner& worker);
+    std::vector<BarcodeResult> processRegionsOfInterest(const cv::Mat& image, const cv::Mat& inverted,
+                                                        const DecoderPlan& plan, FrameDeadline& deadline);
+    std::vector<BarcodeResult> processWithColorInversion(const cv::Mat& image, const cv::Mat& inverted,
+                                                         const DecoderPlan& plan, FrameDeadline& deadline);
+    std::vector<BarcodeResult> processImage(const cv::Mat& image, const DecoderPlan& plan, FrameDeadline& deadline,
+                                            ScanCancellationToken* token = nullptr);
+    std::vector<BarcodeResult> processInvertedImage(const cv::Mat& inverted, const DecoderPlan& plan,
+                                                    FrameDeadline& deadline, ScanCancellationToken& token);
+    // Inverts image unless inverted already holds the inverted view
+    std::vector<BarcodeResult> processInvertedPolarity(const cv::Mat& image, const cv::Mat& inverted,
+                                                       const DecoderPlan& plan, FrameDeadline& deadline,
+                                                       ScanCancellationToken& token);
+    std::vector<BarcodeResult> processZXingEscalation(const cv::Mat& image, const DecoderPlan& plan, FrameDeadline& deadline,
+                                                      std::vector<DecodeCandidate>& candidates, bool found_earlier);
+    std::vector<BarcodeResult> processZXingDirect(const cv::Mat& image, const DecoderPlan& plan, FrameDeadline& deadline,
+                                                  std::vector<DecodeCandidate>& candidates);
+    std::vector<BarcodeResult> processZXingScales(const cv::Mat& image, const DecoderPlan& plan, FrameDeadline& deadline,
+                                                  std::vector<DecodeCandidate>& candidates);
+    std::vector<double> selectScales(const cv::Mat& image, const cv::Mat& cleaned, const DecoderPlan& plan);
+    double estimateFrameModuleSize(const cv::Mat& image, const cv::Mat& cleaned, double chain_scale,
+                                   const DecoderPlan& plan);
+    std::vector<BarcodeResult> processPyramidLevel(size_t index, const DecoderPlan& plan, FrameDeadline& deadline,
+                                                   std::vector<DecodeCandidate>& candidates);
+    std::vector<BarcodeResult> processZXing(const cv::Mat& image, double to_frame, const DecoderPlan& plan,
+                                            FrameDeadline& deadline, std::vector<DecodeCandidate>& candidates);
+    // Request for image with everything but the engine-specific fields set
+    DecodeRequest makeDecodeRequest(const cv::Mat& image, const DecoderPlan& plan, FrameDeadline& deadline,
+                                    ScanCancellationToken* token);
 
     std::shared_ptr<RecognitionContext> context;
     std::shared_ptr<BarcodeScannerSettings> settings;
+    std::shared_ptr<const DecoderPlan> plan;  // Recompiled when the settings generation changes
     std::vector<BarcodeResult> last_scan_results;
+    std::shared_ptr<BarcodeTextArena> text_arena;  // Reused once no result of the previous frame is held
+    std::unique_ptr<DecoderBackend> backends[ENGINE_COUNT];  // Null for engines not compiled in
+    uint64_t configured_generation;  // Plan the backends and the pipeline were set up for
+    LumaPlanes luma_planes;  // Buffers reused between frames
+    FrameBufferPool buffer_pool;  // Every other per-frame scratch image
+    PreprocessingPipeline preprocessing;  // Rebuilt with the plan, keeps its buffers between frames
+    ImagePyramid pyramid;  // Levels of the image being decoded, from buffer_pool
+    MultiScaleOptions multi_scale_options;
+    size_t peak_workspace_bytes;
+    std::shared_ptr<ScanMetrics> metrics;
+    FrameTracer tracer;
+    FrameTracer* frame_tracer;  // tracer, or the tiling scanner's for a tile worker
+    FrameTraceCallback trace_callback;
+    uint64_t frames_processed;
+    BarcodeLocalizer localizer;  // Used when search_whole_image is off
+    BarcodeTracker<BarcodeResult> tracker;  // Used when temporal_tracking is on
+    uint64_t tracked_sequence_id;  // Sequence the tracks belong to
+    std::vector<std::unique_ptr<BarcodeScanner>> tile_workers;  // Created on the first tiled frame, kept with their buffers
+    bool concurrent_inversion;
+    std::unique_ptr<ScanTaskWorker> inversion_worker;  // Created on the first concurrent inverted pass
     bool setup_completed;
 };
 
+// Stable upper-case name for logs and machine-readable output, e.g. "SUCCESS"
+const char* getScanStatusName(ScanStatus status);
+
 // Scandit-style factory functions
 std::shared_ptr<RecognitionContext> createRecognitionContext();
 std::shared_ptr<BarcodeScannerSettings> createScannerSettings(ScanPreset preset = PRESET_SINGLE_FRAME_MODE);
 void configureScannerForShippingLabels(std::shared_ptr<BarcodeScannerSettings> settings);
+// Shares opencv_image's reference-counted buffer, no pixels are copied
 ImageDescription createImageDescription(const cv::Mat& opencv_image);
+// Wraps caller-owned pixels without copying; the buffer must stay valid and
+// unmodified until every processFrame() call using the description returns.
+// row_bytes 0 means tightly packed rows; a negative row_bytes or one shorter
+// than a row leaves image_data empty, which processFrame() reports as
+// SCAN_INVALID_IMAGE.
+ImageDescription createImageDescriptionView(const uint8_t* pixels, int width, int height, int row_bytes, PixelFormat format);
 
 #endif // BARCODE_SCANNER_LIB_H 
\ No newline at end of file
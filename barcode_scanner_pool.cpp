@@ -0,0 +1,201 @@
+#include "barcode_scanner_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+static uint64_t packRange(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(begin) << 32) | end;
+}
+
+BarcodeScannerPool::BarcodeScannerPool(std::shared_ptr<RecognitionContext> ctx,
+                                       std::shared_ptr<BarcodeScannerSettings> sett,
+                                       size_t worker_count)
+    : context(ctx), metrics(std::make_shared<ScanMetrics>()), batch_id(0), busy_workers(0), stopping(false),
+      batch_frames(nullptr), batch_results(nullptr) {
+
+    if (!sett) {
+        throw std::runtime_error("Invalid scanner settings");
+    }
+
+    if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    settings_snapshot = std::make_shared<BarcodeScannerSettings>(*sett);
+    // Workers see unrelated frames in any order, so there is nothing to track
+    settings_snapshot->setTemporalTrackingEnabled(false);
+    for (size_t i = 0; i < worker_count; ++i) {
+        scanners.push_back(std::make_unique<BarcodeScanner>(context, settings_snapshot));
+        scanners.back()->setScanMetrics(metrics);
+        // The other workers already keep every core busy
+        scanners.back()->setConcurrentInversion(worker_count == 1);
+    }
+
+    work_ranges.reset(new WorkRange[worker_count]);
+    for (size_t i = 0; i < worker_count; ++i) {
+        work_ranges[i].range.store(packRange(0, 0), std::memory_order_relaxed);
+    }
+
+    workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(&BarcodeScannerPool::workerLoop, this, i);
+    }
+}
+
+BarcodeScannerPool::~BarcodeScannerPool() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+std::vector<FrameScanResult> BarcodeScannerPool::processFrames(const std::vector<ImageDescription>& frames) {
+    return processFrames(frames.data(), frames.size());
+}
+
+std::vector<FrameScanResult> BarcodeScannerPool::processFrames(const ImageDescription* frames, size_t count) {
+    std::vector<FrameScanResult> results(count);
+    if (count == 0) return results;
+
+    if (count > UINT32_MAX) {
+        throw std::length_error("Batch too large");
+    }
+
+    std::lock_guard<std::mutex> batch_lock(batch_mutex);
+
+    // Hand every worker an equal contiguous slice, the remainder goes to the first ones
+    size_t worker_count = workers.size();
+    size_t slice = count / worker_count;
+    size_t remainder = count % worker_count;
+    size_t begin = 0;
+    for (size_t i = 0; i < worker_count; ++i) {
+        size_t end = begin + slice + (i < remainder ? 1 : 0);
+        work_ranges[i].range.store(packRange(static_cast<uint32_t>(begin), static_cast<uint32_t>(end)),
+                                   std::memory_order_relaxed);
+        begin = end;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        batch_frames = frames;
+        batch_results = results.data();
+        busy_workers = worker_count;
+        ++batch_id;
+        work_available.notify_all();
+        batch_done.wait(lock, [this] { return busy_workers == 0; });
+        batch_frames = nullptr;
+        batch_results = nullptr;
+    }
+
+    return results;
+}
+
+void BarcodeScannerPool::updateSettings(std::shared_ptr<BarcodeScannerSettings> sett) {
+    if (!sett) {
+        throw std::runtime_error("Invalid scanner settings");
+    }
+
+    // Workers are idle while batch_mutex is held, so their scanners can be replaced
+    std::lock_guard<std::mutex> batch_lock(batch_mutex);
+    settings_snapshot = std::make_shared<BarcodeScannerSettings>(*sett);
+    // Workers see unrelated frames in any order, so there is nothing to track
+    settings_snapshot->setTemporalTrackingEnabled(false);
+    for (auto& scanner : scanners) {
+        scanner = std::make_unique<BarcodeScanner>(context, settings_snapshot);
+        scanner->setScanMetrics(metrics);
+        scanner->setConcurrentInversion(scanners.size() == 1);
+    }
+}
+
+ScanStatistics BarcodeScannerPool::getScanStatistics() const {
+    return metrics->getStatistics();
+}
+
+size_t BarcodeScannerPool::getWorkerCount() const {
+    return workers.size();
+}
+
+void BarcodeScannerPool::workerLoop(size_t worker_index) {
+    uint64_t seen_batch = 0;
+
+    for (;;) {
+        const ImageDescription* frames;
+        FrameScanResult* results;
+        {
+            std::unique_lock<std::mutex> lock(state_mutex);
+            work_available.wait(lock, [&] { return stopping || batch_id != seen_batch; });
+            if (stopping) return;
+            seen_batch = batch_id;
+            frames = batch_frames;
+            results = batch_results;
+        }
+
+        BarcodeScanner& scanner = *scanners[worker_index];
+        uint32_t frame_index;
+        while (claimFrame(worker_index, frame_index)) {
+            FrameScanResult& out = results[frame_index];
+            try {
+                out.status = scanner.processFrame(frames[frame_index], out.results);
+            } catch (const std::exception&) {
+                out.results.clear();
+                out.status = SCAN_PROCESSING_ERROR;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (--busy_workers == 0) {
+                batch_done.notify_all();
+            }
+        }
+    }
+}
+
+bool BarcodeScannerPool::claimFrame(size_t worker_index, uint32_t& frame_index) {
+    if (popFront(work_ranges[worker_index].range, frame_index)) {
+        return true;
+    }
+
+    // Own slice is drained, steal from the far end of the others
+    size_t worker_count = workers.size();
+    for (size_t offset = 1; offset < worker_count; ++offset) {
+        size_t victim = (worker_index + offset) % worker_count;
+        if (popBack(work_ranges[victim].range, frame_index)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BarcodeScannerPool::popFront(std::atomic<uint64_t>& range, uint32_t& frame_index) {
+    uint64_t current = range.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t begin = static_cast<uint32_t>(current >> 32);
+        uint32_t end = static_cast<uint32_t>(current);
+        if (begin >= end) return false;
+        if (range.compare_exchange_weak(current, packRange(begin + 1, end),
+                                        std::memory_order_acq_rel, std::memory_order_acquire)) {
+            frame_index = begin;
+            return true;
+        }
+    }
+}
+
+bool BarcodeScannerPool::popBack(std::atomic<uint64_t>& range, uint32_t& frame_index) {
+    uint64_t current = range.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t begin = static_cast<uint32_t>(current >> 32);
+        uint32_t end = static_cast<uint32_t>(current);
+        if (begin >= end) return false;
+        if (range.compare_exchange_weak(current, packRange(begin, end - 1),
+                                        std::memory_order_acq_rel, std::memory_order_acquire)) {
+            frame_index = end - 1;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef BARCODE_SCANNER_POOL_H
+#define BARCODE_SCANNER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "barcode_scanner_lib.h"
+
+// Outcome of one frame in a batch, results are owned per frame
+struct FrameScanResult {
+    ScanStatus status;
+    std::vector<BarcodeResult> results;
+};
+
+// Fixed set of worker threads, each owning its own BarcodeScanner. All
+// workers read one settings snapshot taken at construction (or by
+// updateSettings()), so the caller may keep editing its own settings object.
+//
+// A batch is split into one contiguous range per worker; a worker that runs
+// out of frames steals from the back of another worker's range.
+//
+// OpenCV runs some filters on its own thread pool; when every core already
+// has a scanner worker, cv::setNumThreads(1) usually gives better scaling.
+class BarcodeScannerPool {
+public:
+    // worker_count == 0 uses std::thread::hardware_concurrency()
+    BarcodeScannerPool(std::shared_ptr<RecognitionContext> ctx,
+                       std::shared_ptr<BarcodeScannerSettings> sett,
+                       size_t worker_count = 0);
+    ~BarcodeScannerPool();
+
+    BarcodeScannerPool(const BarcodeScannerPool&) = delete;
+    BarcodeScannerPool& operator=(const BarcodeScannerPool&) = delete;
+
+    // Blocks until every frame is scanned; result i belongs to frames[i].
+    // Concurrent calls are serialised.
+    std::vector<FrameScanResult> processFrames(const ImageDescription* frames, size_t count);
+    std::vector<FrameScanResult> processFrames(const std::vector<ImageDescription>& frames);
+
+    // Takes a new settings snapshot, applied from the next batch on
+    void updateSettings(std::shared_ptr<BarcodeScannerSettings> sett);
+
+    size_t getWorkerCount() const;
+    // Summed over every worker, and kept across updateSettings()
+    ScanStatistics getScanStatistics() const;
+
+private:
+    // [begin, end) frame range packed into one word so owner and thieves
+    // can both update it with a single compare-exchange
+    struct alignas(64) WorkRange {
+        std::atomic<uint64_t> range;
+    };
+
+    void workerLoop(size_t worker_index);
+    bool claimFrame(size_t worker_index, uint32_t& frame_index);
+    static bool popFront(std::atomic<uint64_t>& range, uint32_t& frame_index);
+    static bool popBack(std::atomic<uint64_t>& range, uint32_t& frame_index);
+
+    std::shared_ptr<RecognitionContext> context;
+    std::shared_ptr<BarcodeScannerSettings> settings_snapshot;
+    std::shared_ptr<ScanMetrics> metrics;  // Shared by every worker's scanner
+    std::vector<std::unique_ptr<BarcodeScanner>> scanners;
+    std::unique_ptr<WorkRange[]> work_ranges;
+    std::vector<std::thread> workers;
+
+    std::mutex batch_mutex;  // Serialises processFrames() and updateSettings()
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable batch_done;
+    uint64_t batch_id;
+    size_t busy_workers;
+    bool stopping;
+
+    const ImageDescription* batch_frames;
+    FrameScanResult* batch_results;
+};
+
+#endif // BARCODE_SCANNER_POOL_H
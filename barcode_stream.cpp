@@ -0,0 +1,320 @@
+#include "barcode_stream.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#include "barcode_logger.h"
+
+const char* getStreamStageName(StreamStage stage) {
+    switch (stage) {
+        case STREAM_STAGE_CAPTURE: return "capture";
+        case STREAM_STAGE_CONVERT: return "convert";
+        case STREAM_STAGE_DECODE: return "decode";
+        case STREAM_STAGE_SINK: return "sink";
+        default: return "unknown";
+    }
+}
+
+StreamPipelineOptions defaultStreamPipelineOptions() {
+    StreamPipelineOptions options;
+    options.decode_workers = 0;
+    options.queue_capacity = 8;
+    options.drop_policy = STREAM_DROP_OLDEST;
+    return options;
+}
+
+static bool isCameraIndex(const std::string& source) {
+    return !source.empty() && std::all_of(source.begin(), source.end(), [](unsigned char c) {
+        return std::isdigit(c) != 0;
+    });
+}
+
+VideoCaptureSource::VideoCaptureSource(const std::string& source) {
+    if (isCameraIndex(source)) {
+        // CAP_ANY picks V4L2 on Linux and AVFoundation on macOS
+        capture.open(std::stoi(source), cv::CAP_ANY);
+    } else {
+        capture.open(source, cv::CAP_ANY);
+    }
+
+    if (!capture.isOpened()) {
+        throw std::runtime_error("Could not open video source: " + source);
+    }
+}
+
+bool VideoCaptureSource::read(cv::Mat& frame) {
+    return capture.read(frame) && !frame.empty();
+}
+
+BarcodeStreamPipeline::BarcodeStreamPipeline(std::unique_ptr<FrameSource> src,
+                                             std::shared_ptr<RecognitionContext> ctx,
+                                             std::shared_ptr<BarcodeScannerSettings> sett,
+                                             StreamResultSink result_sink,
+                                             const StreamPipelineOptions& pipeline_options)
+    : source(std::move(src)), context(ctx), sink(std::move(result_sink)), options(pipeline_options),
+      capture_queue(pipeline_options.queue_capacity), decode_queue(pipeline_options.queue_capacity),
+      result_queue(pipeline_options.queue_capacity),
+      stopping(false), capture_done(false), convert_done(false), active_decoders(0), sink_done(false),
+      started(false) {
+
+    if (!source) {
+        throw std::runtime_error("Invalid frame source");
+    }
+    if (!sett) {
+        throw std::runtime_error("Invalid scanner settings");
+    }
+
+    if (options.decode_workers == 0) {
+        options.decode_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (auto& stage : counters) {
+        stage.processed = 0;
+        stage.dropped = 0;
+        stage.total_latency_us = 0;
+        stage.max_latency_us = 0;
+    }
+
+    settings_snapshot = std::make_shared<BarcodeScannerSettings>(*sett);
+    if (options.decode_workers > 1) {
+        // Workers take frames as they come, so none sees a whole sequence
+        settings_snapshot->setTemporalTrackingEnabled(false);
+    }
+    for (size_t i = 0; i < options.decode_workers; ++i) {
+        scanners.push_back(std::make_unique<BarcodeScanner>(context, settings_snapshot));
+        scanners.back()->setConcurrentInversion(options.decode_workers == 1);
+    }
+}
+
+BarcodeStreamPipeline::~BarcodeStreamPipeline() {
+    stop();
+}
+
+void BarcodeStreamPipeline::start() {
+    if (started) return;
+    started = true;
+
+    context->startNewFrameSequence();
+    active_decoders = options.decode_workers;
+
+    sink_thread = std::thread(&BarcodeStreamPipeline::sinkLoop, this);
+    for (size_t i = 0; i < options.decode_workers; ++i) {
+        decode_threads.emplace_back(&BarcodeStreamPipeline::decodeLoop, this, i);
+    }
+    convert_thread = std::thread(&BarcodeStreamPipeline::convertLoop, this);
+    capture_thread = std::thread(&BarcodeStreamPipeline::captureLoop, this);
+
+    BARCODE_LOG_INFO("Stream pipeline started with " << options.decode_workers << " decode worker(s)");
+}
+
+void BarcodeStreamPipeline::stop() {
+    stopping = true;
+    joinAll();
+}
+
+void BarcodeStreamPipeline::wait() {
+    joinAll();
+}
+
+void BarcodeStreamPipeline::joinAll() {
+    if (!started) return;
+
+    // Upstream first, each stage exits once its input is done and drained
+    if (capture_thread.joinable()) capture_thread.join();
+    if (convert_thread.joinable()) convert_thread.join();
+    for (auto& thread : decode_threads) {
+        if (thread.joinable()) thread.join();
+    }
+    if (sink_thread.joinable()) sink_thread.join();
+
+    if (context->isFrameSequenceStarted()) {
+        context->endFrameSequence();
+        BARCODE_LOG_INFO("Stream pipeline stopped");
+    }
+}
+
+bool BarcodeStreamPipeline::isRunning() const {
+    return started && !sink_done;
+}
+
+StreamStageStats BarcodeStreamPipeline::getStageStats(StreamStage stage) const {
+    StreamStageStats stats;
+    const StageCounters& stage_counters = counters[stage];
+
+    switch (stage) {
+        case STREAM_STAGE_CONVERT:
+            stats.queue_depth = capture_queue.size();
+            stats.queue_capacity = capture_queue.capacity();
+            break;
+        case STREAM_STAGE_DECODE:
+            stats.queue_depth = decode_queue.size();
+            stats.queue_capacity = decode_queue.capacity();
+            break;
+        case STREAM_STAGE_SINK:
+            stats.queue_depth = result_queue.size();
+            stats.queue_capacity = result_queue.capacity();
+            break;
+        default:
+            stats.queue_depth = 0;
+            stats.queue_capacity = 0;
+    }
+
+    stats.processed = stage_counters.processed.load(std::memory_order_relaxed);
+    stats.dropped = stage_counters.dropped.load(std::memory_order_relaxed);
+    uint64_t total_us = stage_counters.total_latency_us.load(std::memory_order_relaxed);
+    stats.mean_latency_ms = stats.processed > 0 ? total_us / 1000.0 / stats.processed : 0.0;
+    stats.max_latency_ms = stage_counters.max_latency_us.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+void BarcodeStreamPipeline::recordLatency(StageCounters& stage_counters, std::chrono::steady_clock::time_point since) {
+    uint64_t latency_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - since).count());
+
+    stage_counters.processed.fetch_add(1, std::memory_order_relaxed);
+    stage_counters.total_latency_us.fetch_add(latency_us, std::memory_order_relaxed);
+    uint64_t previous = stage_counters.max_latency_us.load(std::memory_order_relaxed);
+    while (latency_us > previous &&
+           !stage_counters.max_latency_us.compare_exchange_weak(previous, latency_us, std::memory_order_relaxed)) {
+    }
+}
+
+// Applies the drop policy; drops are counted on the stage reading the queue
+void BarcodeStreamPipeline::pushFrame(BoundedQueue<StreamFrame>& queue, StreamFrame& frame, StageCounters& receiver) {
+    frame.queued = std::chrono::steady_clock::now();
+    int idle_rounds = 0;
+
+    while (!queue.tryPush(frame)) {
+        switch (options.drop_policy) {
+            case STREAM_DROP_NEWEST:
+                receiver.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            case STREAM_DROP_OLDEST: {
+                StreamFrame oldest;
+                if (queue.tryPop(oldest)) {
+                    receiver.dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            }
+            case STREAM_BLOCK:
+            default:
+                // Only capture gives up on stop(); frames already queued
+                // behind it keep flowing to the sink
+                if (stopping && &queue == &capture_queue) {
+                    receiver.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                backOff(idle_rounds);
+        }
+    }
+}
+
+void BarcodeStreamPipeline::captureLoop() {
+    uint64_t next_index = 0;
+
+    while (!stopping) {
+        StreamFrame frame;
+        auto started_read = std::chrono::steady_clock::now();
+        if (!source->read(frame.image)) {
+            BARCODE_LOG_INFO("Frame source ended after " << next_index << " frame(s)");
+            break;
+        }
+        frame.index = next_index++;
+        frame.captured = std::chrono::steady_clock::now();
+        recordLatency(counters[STREAM_STAGE_CAPTURE], started_read);
+
+        pushFrame(capture_queue, frame, counters[STREAM_STAGE_CONVERT]);
+    }
+
+    capture_done = true;
+}
+
+// Colour conversion runs here so decode workers only see luma
+void BarcodeStreamPipeline::convertLoop() {
+    int idle_rounds = 0;
+
+    for (;;) {
+        StreamFrame frame;
+        if (!capture_queue.tryPop(frame)) {
+            if (capture_done && capture_queue.empty()) break;
+            backOff(idle_rounds);
+            continue;
+        }
+        idle_rounds = 0;
+
+        int channels = frame.image.channels();
+        if (channels == 3 || channels == 4) {
+            cv::Mat gray;
+            cv::cvtColor(frame.image, gray, channels == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+            frame.image = gray;
+        }
+        recordLatency(counters[STREAM_STAGE_CONVERT], frame.queued);
+
+        pushFrame(decode_queue, frame, counters[STREAM_STAGE_DECODE]);
+    }
+
+    convert_done = true;
+}
+
+void BarcodeStreamPipeline::decodeLoop(size_t worker_index) {
+    BarcodeScanner& scanner = *scanners[worker_index];
+    int idle_rounds = 0;
+
+    for (;;) {
+        StreamFrame frame;
+        if (!decode_queue.tryPop(frame)) {
+            if (convert_done && decode_queue.empty()) break;
+            backOff(idle_rounds);
+            continue;
+        }
+        idle_rounds = 0;
+
+        QueuedResult queued;
+        queued.result.frame_index = frame.index;
+        try {
+            queued.result.status = scanner.processFrame(createImageDescription(frame.image), queued.result.results);
+        } catch (const std::exception& e) {
+            BARCODE_LOG_ERROR("Frame " << frame.index << " failed: " << e.what());
+            queued.result.status = SCAN_PROCESSING_ERROR;
+            queued.result.results.clear();
+        }
+        queued.result.latency = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - frame.captured);
+        recordLatency(counters[STREAM_STAGE_DECODE], frame.queued);
+
+        // Decoded frames are never dropped, a slow sink stalls decoding instead
+        queued.queued = std::chrono::steady_clock::now();
+        int full_rounds = 0;
+        while (!result_queue.tryPush(queued)) {
+            backOff(full_rounds);
+        }
+    }
+
+    active_decoders.fetch_sub(1);
+}
+
+void BarcodeStreamPipeline::sinkLoop() {
+    int idle_rounds = 0;
+
+    for (;;) {
+        QueuedResult queued;
+        if (!result_queue.tryPop(queued)) {
+            if (active_decoders == 0 && result_queue.empty()) break;
+            backOff(idle_rounds);
+            continue;
+        }
+        idle_rounds = 0;
+
+        if (sink) {
+            try {
+                sink(queued.result);
+            } catch (const std::exception& e) {
+                BARCODE_LOG_ERROR("Result sink failed on frame " << queued.result.frame_index << ": " << e.what());
+            }
+        }
+        recordLatency(counters[STREAM_STAGE_SINK], queued.queued);
+    }
+
+    sink_done = true;
+}
@@ -0,0 +1,169 @@
+#ifndef BARCODE_STREAM_H
+#define BARCODE_STREAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "barcode_queue.h"
+#include "barcode_scanner_lib.h"
+
+// What a full queue does with the frame that does not fit
+enum StreamDropPolicy {
+    STREAM_DROP_OLDEST,  // Discard the longest-waiting frame, keeps latency low
+    STREAM_DROP_NEWEST,  // Discard the incoming frame, keeps the frames already queued
+    STREAM_BLOCK         // Stall the upstream stage, no frame is lost
+};
+
+// Stages in pipeline order; each one but capture reads from its own queue
+enum StreamStage {
+    STREAM_STAGE_CAPTURE = 0,
+    STREAM_STAGE_CONVERT,
+    STREAM_STAGE_DECODE,
+    STREAM_STAGE_SINK,
+    STREAM_STAGE_COUNT
+};
+
+const char* getStreamStageName(StreamStage stage);
+
+// Snapshot of one stage. Latency runs from the frame entering the stage's
+// input queue to the stage handing it on, so it includes queue wait.
+struct StreamStageStats {
+    size_t queue_depth;
+    size_t queue_capacity;
+    uint64_t processed;
+    uint64_t dropped;  // Frames this stage's input queue discarded
+    double mean_latency_ms;
+    double max_latency_ms;
+};
+
+// Results of one frame, delivered to the sink in completion order; with
+// several decode workers that is not always capture order
+struct StreamResult {
+    uint64_t frame_index;
+    ScanStatus status;
+    std::vector<BarcodeResult> results;
+    std::chrono::microseconds latency;  // Capture to sink
+};
+
+using StreamResultSink = std::function<void(const StreamResult&)>;
+
+// Produces frames for the capture stage
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+    // Returns false at the end of the stream
+    virtual bool read(cv::Mat& frame) = 0;
+};
+
+// A camera index ("0", opened through V4L2 on Linux), a video file, or a
+// stream URL such as rtsp://... (through FFmpeg). Throws if it cannot be
+// opened.
+class VideoCaptureSource : public FrameSource {
+public:
+    explicit VideoCaptureSource(const std::string& source);
+    bool read(cv::Mat& frame) override;
+
+private:
+    cv::VideoCapture capture;
+};
+
+struct StreamPipelineOptions {
+    size_t decode_workers;  // 0 uses std::thread::hardware_concurrency()
+    size_t queue_capacity;  // Per queue, rounded up to a power of two
+    StreamDropPolicy drop_policy;
+};
+
+StreamPipelineOptions defaultStreamPipelineOptions();
+
+// Capture -> convert -> decode -> sink, one thread per stage and a pool of
+// decode workers, connected by bounded lock-free queues. The capture and
+// convert queues follow the drop policy; the result queue always blocks so
+// a decoded frame is never lost.
+//
+// The pipeline owns a frame sequence on the context from start() to
+// stop(). Temporal tracking needs frames in order and is only kept with a
+// single decode worker.
+class BarcodeStreamPipeline {
+public:
+    BarcodeStreamPipeline(std::unique_ptr<FrameSource> source,
+                          std::shared_ptr<RecognitionContext> ctx,
+                          std::shared_ptr<BarcodeScannerSettings> sett,
+                          StreamResultSink sink,
+                          const StreamPipelineOptions& options = defaultStreamPipelineOptions());
+    ~BarcodeStreamPipeline();
+
+    BarcodeStreamPipeline(const BarcodeStreamPipeline&) = delete;
+    BarcodeStreamPipeline& operator=(const BarcodeStreamPipeline&) = delete;
+
+    void start();
+    // Stops capturing and waits until the queued frames reached the sink
+    void stop();
+    // Blocks until the source ran out and every frame was delivered
+    void wait();
+    // False once the source ran out or stop() was called, and the queues drained
+    bool isRunning() const;
+
+    StreamStageStats getStageStats(StreamStage stage) const;
+
+private:
+    struct StreamFrame {
+        uint64_t index;
+        std::chrono::steady_clock::time_point captured;
+        std::chrono::steady_clock::time_point queued;  // Entered the current queue
+        cv::Mat image;
+    };
+
+    struct QueuedResult {
+        std::chrono::steady_clock::time_point queued;
+        StreamResult result;
+    };
+
+    struct StageCounters {
+        std::atomic<uint64_t> processed;
+        std::atomic<uint64_t> dropped;
+        std::atomic<uint64_t> total_latency_us;
+        std::atomic<uint64_t> max_latency_us;
+    };
+
+    void captureLoop();
+    void convertLoop();
+    void decodeLoop(size_t worker_index);
+    void sinkLoop();
+    void pushFrame(BoundedQueue<StreamFrame>& queue, StreamFrame& frame, StageCounters& receiver);
+    void recordLatency(StageCounters& counters, std::chrono::steady_clock::time_point since);
+    void joinAll();
+
+    std::unique_ptr<FrameSource> source;
+    std::shared_ptr<RecognitionContext> context;
+    std::shared_ptr<BarcodeScannerSettings> settings_snapshot;
+    StreamResultSink sink;
+    StreamPipelineOptions options;
+
+    BoundedQueue<StreamFrame> capture_queue;  // Capture -> convert
+    BoundedQueue<StreamFrame> decode_queue;   // Convert -> decode
+    BoundedQueue<QueuedResult> result_queue;  // Decode -> sink
+    StageCounters counters[STREAM_STAGE_COUNT];
+
+    std::vector<std::unique_ptr<BarcodeScanner>> scanners;
+    std::thread capture_thread;
+    std::thread convert_thread;
+    std::vector<std::thread> decode_threads;
+    std::thread sink_thread;
+
+    std::atomic<bool> stopping;
+    std::atomic<bool> capture_done;
+    std::atomic<bool> convert_done;
+    std::atomic<size_t> active_decoders;
+    std::atomic<bool> sink_done;
+    bool started;
+};
+
+#endif // BARCODE_STREAM_H
@@ -0,0 +1,95 @@
+#ifndef BARCODE_TEXT_ARENA_H
+#define BARCODE_TEXT_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Per-frame storage for result text. Payloads and format details are
+// appended to a few large chunks instead of each getting its own string,
+// and results only hold string_views into it. Chunks never move, so views
+// stay valid until reset().
+//
+// Results keep their arena alive through a shared_ptr (see recycle()), so
+// copies handed to other threads or kept by the tracker never dangle.
+class BarcodeTextArena {
+public:
+    explicit BarcodeTextArena(size_t chunk_size = 4096)
+        : chunk_size(chunk_size), current(0), used(0), stored(0) {}
+
+    BarcodeTextArena(const BarcodeTextArena&) = delete;
+    BarcodeTextArena& operator=(const BarcodeTextArena&) = delete;
+
+    // Safe to call from the normal and inverted passes of one frame at once
+    std::string_view store(std::string_view text) {
+        if (text.empty()) return std::string_view();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (current == chunks.size() || used + text.size() > chunks[current].size) {
+            nextChunk(text.size());
+        }
+        char* destination = chunks[current].data.get() + used;
+        std::memcpy(destination, text.data(), text.size());
+        used += text.size();
+        stored += text.size();
+        return std::string_view(destination, text.size());
+    }
+
+    // Invalidates every view handed out; the chunks are kept for reuse
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = 0;
+        used = 0;
+        stored = 0;
+    }
+
+    size_t bytesStored() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stored;
+    }
+
+    // Arena for the next frame: arena itself once no result refers to it
+    // any more, otherwise a fresh one, so results still held elsewhere keep
+    // their text
+    static std::shared_ptr<BarcodeTextArena> recycle(std::shared_ptr<BarcodeTextArena>& arena) {
+        if (arena && arena.use_count() == 1) {
+            arena->reset();
+        } else {
+            arena = std::make_shared<BarcodeTextArena>();
+        }
+        return arena;
+    }
+
+private:
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    // Moves on to the next kept chunk that fits, or allocates one
+    void nextChunk(size_t needed) {
+        if (current < chunks.size()) ++current;
+        while (current < chunks.size() && chunks[current].size < needed) ++current;
+
+        if (current == chunks.size()) {
+            Chunk chunk;
+            chunk.size = std::max(chunk_size, needed);
+            chunk.data.reset(new char[chunk.size]);
+            chunks.push_back(std::move(chunk));
+        }
+        used = 0;
+    }
+
+    const size_t chunk_size;
+    std::vector<Chunk> chunks;
+    size_t current;  // Chunk being filled
+    size_t used;     // Bytes used in the current chunk
+    size_t stored;
+    mutable std::mutex mutex;
+};
+
+#endif // BARCODE_TEXT_ARENA_H
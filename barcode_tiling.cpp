@@ -0,0 +1,53 @@
+#include "barcode_tiling.h"
+
+#include <algorithm>
+
+TilingOptions defaultTilingOptions() {
+    TilingOptions options;
+    options.expected_symbol_size = 0;
+    options.symbols_per_tile = 8;
+    options.min_tile_size = 1024;
+    options.max_workers = 0;
+    return options;
+}
+
+bool operator==(const TilingOptions& a, const TilingOptions& b) {
+    return a.expected_symbol_size == b.expected_symbol_size && a.symbols_per_tile == b.symbols_per_tile &&
+           a.min_tile_size == b.min_tile_size && a.max_workers == b.max_workers;
+}
+
+bool operator!=(const TilingOptions& a, const TilingOptions& b) {
+    return !(a == b);
+}
+
+// Tile origins and the common tile length along one axis; the tiles are
+// spread evenly so the last one is not a thin sliver
+static std::vector<int> splitAxis(int length, int stride, int overlap, int& tile_length) {
+    std::vector<int> origins;
+    int count = std::max(1, (length - overlap + stride - 1) / stride);
+    int even_stride = (length - overlap + count - 1) / count;
+    tile_length = std::min(length, even_stride + overlap);
+    for (int i = 0; i < count; ++i) {
+        origins.push_back(std::min(i * even_stride, length - tile_length));
+    }
+    return origins;
+}
+
+std::vector<cv::Rect> computeTileGrid(cv::Size frame, const TilingOptions& options) {
+    std::vector<cv::Rect> tiles;
+    int overlap = options.expected_symbol_size;
+    if (overlap <= 0 || frame.width <= 0 || frame.height <= 0) return tiles;
+
+    int stride = std::max(options.min_tile_size, options.symbols_per_tile * overlap);
+    if (frame.width <= stride + overlap && frame.height <= stride + overlap) return tiles;
+
+    int tile_width = 0, tile_height = 0;
+    std::vector<int> columns = splitAxis(frame.width, stride, overlap, tile_width);
+    std::vector<int> rows = splitAxis(frame.height, stride, overlap, tile_height);
+    for (int y : rows) {
+        for (int x : columns) {
+            tiles.push_back(cv::Rect(x, y, tile_width, tile_height));
+        }
+    }
+    return tiles;
+}
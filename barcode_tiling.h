@@ -0,0 +1,27 @@
+#ifndef BARCODE_TILING_H
+#define BARCODE_TILING_H
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// Tuning for tiled decoding of very large frames
+struct TilingOptions {
+    int expected_symbol_size;  // Largest code side expected, in pixels; 0 turns tiling off
+    int symbols_per_tile;      // Tile side in symbol sizes, before the overlap
+    int min_tile_size;         // Tiles are never smaller than this, in pixels
+    int max_workers;           // Tiles decoded at once, 0 for one per hardware thread
+};
+
+TilingOptions defaultTilingOptions();
+
+bool operator==(const TilingOptions& a, const TilingOptions& b);
+bool operator!=(const TilingOptions& a, const TilingOptions& b);
+
+// Tiles covering a frame of the given size, row by row. Neighbours share
+// expected_symbol_size pixels, so every code up to that size lies whole
+// inside at least one tile. Empty when tiling is off or the frame fits in
+// one tile.
+std::vector<cv::Rect> computeTileGrid(cv::Size frame, const TilingOptions& options);
+
+#endif // BARCODE_TILING_H
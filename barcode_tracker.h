@@ -0,0 +1,232 @@
+#ifndef BARCODE_TRACKER_H
+#define BARCODE_TRACKER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "barcode_result_dedup.h"
+
+// Tuning for frame-sequence tracking
+struct BarcodeTrackerOptions {
+    double confidence_decay;      // Multiplied into a track's confidence every frame it is missed
+    double min_confidence;        // Tracks below this are dropped
+    int stable_hits;              // Consecutive decodes before a track may be carried without decoding
+    int max_skip_frames;          // Frames a stable track is carried before it is decoded again
+    double max_patch_difference;  // Mean absolute thumbnail difference still treated as a static scene
+    double search_margin;         // Predicted region grows by this fraction of the code size per side
+    int full_search_interval;     // Frames between full searches while below max_codes
+};
+
+inline BarcodeTrackerOptions defaultTrackerOptions() {
+    BarcodeTrackerOptions options;
+    options.confidence_decay = 0.6;
+    options.min_confidence = 0.2;
+    options.stable_hits = 3;
+    options.max_skip_frames = 5;
+    options.max_patch_difference = 6.0;
+    options.search_margin = 0.5;
+    options.full_search_interval = 10;
+    return options;
+}
+
+// Carries decoded codes from one frame of a sequence to the next. Every
+// frame, each track is first checked against a thumbnail of where it was
+// last decoded: a stable code in a static patch is reported again without
+// decoding. Otherwise only the region predicted from the track's motion is
+// decoded. The full-frame search only runs when there is nothing to track,
+// a track was missed, or every full_search_interval frames while the frame
+// is still short of max_codes. Steady-state cost therefore follows scene
+// motion rather than frame resolution.
+//
+// Works on any result type with data, symbology and location members, so
+// both scanners share it. Keeps scratch buffers; use one tracker per
+// scanner.
+template <typename Result>
+class BarcodeTracker {
+public:
+    explicit BarcodeTracker(const BarcodeTrackerOptions& options = defaultTrackerOptions())
+        : options(options), frames_since_full_search(0) {}
+
+    // Forget every track, e.g. when a new frame sequence starts
+    void reset() {
+        tracks.clear();
+        frames_since_full_search = 0;
+    }
+
+    bool empty() const { return tracks.empty(); }
+    size_t size() const { return tracks.size(); }
+
+    // decode_region(gray, region, results) decodes gray(region) and appends
+    // results in frame coordinates; it returns false if it could not run
+    // (budget exhausted), which leaves the track untouched for this frame.
+    // full_search(gray) returns the results of a normal whole-frame scan.
+    template <typename DecodeRegion, typename FullSearch>
+    std::vector<Result> processFrame(const cv::Mat& gray, int max_codes, DecodeRegion&& decode_region,
+                                     FullSearch&& full_search) {
+        std::vector<Result> results;
+        bool missed = false;
+        ++frames_since_full_search;
+
+        for (auto& track : tracks) {
+            track.reported = false;
+            ++track.frames_since_seen;
+
+            if (isStatic(track, gray)) {
+                ++track.frames_since_verified;
+                track.frames_since_seen = 0;
+                report(track, results);
+                continue;
+            }
+
+            cv::Rect region = predictedRegion(track, gray.size());
+            if (region.empty()) {
+                missed = true;
+                track.confidence *= options.confidence_decay;
+                continue;
+            }
+            std::vector<Result> decoded;
+            if (!decode_region(gray, region, decoded)) continue;
+
+            auto match = std::find_if(decoded.begin(), decoded.end(), [&](const Result& result) {
+                return result.symbology == track.result.symbology && result.data == track.result.data;
+            });
+            if (match != decoded.end()) {
+                confirm(track, *match, gray);
+                report(track, results);
+            } else {
+                missed = true;
+                track.hits = 0;
+                track.confidence *= options.confidence_decay;
+            }
+
+            // Other codes that happened to be inside the region
+            for (auto& result : decoded) {
+                if (match == decoded.end() || &result != &*match) results.push_back(result);
+            }
+        }
+
+        tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [this](const Track& track) {
+            return track.confidence < options.min_confidence;
+        }), tracks.end());
+
+        bool short_of_codes = static_cast<int>(results.size()) < max_codes;
+        if (tracks.empty() || missed ||
+            (short_of_codes && frames_since_full_search >= options.full_search_interval)) {
+            frames_since_full_search = 0;
+            for (auto& result : full_search(gray)) {
+                results.push_back(result);
+            }
+        }
+
+        // New codes, and full-search hits of tracks the predicted region missed
+        for (const auto& result : results) {
+            Track* track = findTrack(result);
+            if (!track) {
+                tracks.push_back(Track(result));
+                track = &tracks.back();
+                track->thumbnail = thumbnailOf(gray, result.location);
+            } else if (!track->reported) {
+                confirm(*track, result, gray);
+            }
+            track->reported = true;
+        }
+
+        return results;
+    }
+
+private:
+    struct Track {
+        explicit Track(const Result& decoded)
+            : result(decoded), velocity(0.f, 0.f), confidence(1.0), hits(1),
+              frames_since_seen(0), frames_since_verified(0), reported(false) {}
+
+        Result result;          // Last decode, at the latest known location
+        cv::Point2f velocity;   // Pixels per frame, smoothed
+        double confidence;
+        int hits;               // Consecutive frames the code was decoded
+        int frames_since_seen;
+        int frames_since_verified;
+        bool reported;          // Already in this frame's results
+        cv::Mat thumbnail;      // The code's patch when it was last decoded
+    };
+
+    static cv::Point2f centerOf(const cv::Rect& rect) {
+        return cv::Point2f(rect.x + rect.width * 0.5f, rect.y + rect.height * 0.5f);
+    }
+
+    cv::Mat thumbnailOf(const cv::Mat& gray, const cv::Rect& location) {
+        cv::Rect clipped = location & cv::Rect(0, 0, gray.cols, gray.rows);
+        if (clipped.empty()) return cv::Mat();
+        cv::Mat thumbnail;
+        cv::resize(gray(clipped), thumbnail, cv::Size(THUMBNAIL_SIDE, THUMBNAIL_SIDE), 0, 0, cv::INTER_AREA);
+        return thumbnail;
+    }
+
+    // A stable code whose patch has not changed can be reported as is
+    bool isStatic(const Track& track, const cv::Mat& gray) {
+        if (track.hits < options.stable_hits || track.frames_since_verified >= options.max_skip_frames) return false;
+        if (track.thumbnail.empty()) return false;
+
+        cv::Rect clipped = track.result.location & cv::Rect(0, 0, gray.cols, gray.rows);
+        if (clipped != track.result.location) return false;
+        cv::resize(gray(clipped), patch, track.thumbnail.size(), 0, 0, cv::INTER_AREA);
+        double difference = cv::norm(patch, track.thumbnail, cv::NORM_L1) / patch.total();
+        return difference <= options.max_patch_difference;
+    }
+
+    // Last location moved by the track's velocity, grown by a margin that
+    // widens with every frame the code was not seen
+    cv::Rect predictedRegion(const Track& track, cv::Size frame_size) const {
+        const cv::Rect& last = track.result.location;
+        cv::Point2f center = centerOf(last) + track.velocity * static_cast<float>(track.frames_since_seen);
+        double margin = options.search_margin * std::max(last.width, last.height) * track.frames_since_seen;
+        int width = static_cast<int>(std::lround(last.width + 2 * margin));
+        int height = static_cast<int>(std::lround(last.height + 2 * margin));
+        cv::Rect region(static_cast<int>(std::lround(center.x - width * 0.5)),
+                        static_cast<int>(std::lround(center.y - height * 0.5)), width, height);
+        return region & cv::Rect(0, 0, frame_size.width, frame_size.height);
+    }
+
+    void confirm(Track& track, const Result& decoded, const cv::Mat& gray) {
+        if (track.frames_since_seen > 0) {
+            cv::Point2f moved = (centerOf(decoded.location) - centerOf(track.result.location)) *
+                                (1.0f / track.frames_since_seen);
+            track.velocity = track.velocity * 0.5f + moved * 0.5f;
+        }
+        track.result = decoded;
+        track.confidence = 1.0;
+        ++track.hits;
+        track.frames_since_seen = 0;
+        track.frames_since_verified = 0;
+        track.thumbnail = thumbnailOf(gray, decoded.location);
+    }
+
+    void report(Track& track, std::vector<Result>& results) {
+        track.reported = true;
+        results.push_back(track.result);
+    }
+
+    // Same payload near where the track was expected
+    Track* findTrack(const Result& result) {
+        Track* best = nullptr;
+        for (auto& track : tracks) {
+            if (track.result.symbology != result.symbology || track.result.data != result.data) continue;
+            if (track.reported && !barcodeLocationsOverlap(track.result.location, result.location)) continue;
+            if (!best || track.reported) best = &track;
+        }
+        return best;
+    }
+
+    static const int THUMBNAIL_SIDE = 32;
+
+    BarcodeTrackerOptions options;
+    std::vector<Track> tracks;
+    int frames_since_full_search;
+    cv::Mat patch;
+};
+
+#endif // BARCODE_TRACKER_H
@@ -0,0 +1,412 @@
+// Decode-path benchmarks over a labelled corpus.
+//
+// Every benchmark runs once per corpus category and reports, next to the
+// usual timings:
+//   items_per_second  frames per second
+//   p50_ms, p99_ms    per-frame latency percentiles
+//   allocs_per_frame  operator new calls per frame
+//   decode_rate       ground-truth payloads found / payloads expected
+//   false_positives   decodes per frame that match no expected payload
+//
+// Set BARCODE_BENCH_CORPUS to a directory with a manifest.csv to run on real
+// images instead of the synthetic corpus (see bench_corpus.h).
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <ZXing/ReadBarcode.h>
+
+#include "bench_corpus.h"
+#include "../barcode_decoder_backend.h"
+#include "../barcode_logger.h"
+#include "../barcode_luma.h"
+#include "../barcode_preprocessing.h"
+#include "../barcode_scanner_lib.h"
+
+// Counts heap allocations made through operator new. OpenCV allocates Mat
+// buffers with its own allocator, so those are not included.
+static std::atomic<size_t> allocation_count(0);
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+static const std::vector<CorpusSample>& corpus() {
+    static const std::vector<CorpusSample> samples = loadBenchCorpus();
+    return samples;
+}
+
+static std::vector<const CorpusSample*> samplesInCategory(const std::string& category) {
+    std::vector<const CorpusSample*> samples;
+    for (const auto& sample : corpus()) {
+        if (sample.category == category) samples.push_back(&sample);
+    }
+    return samples;
+}
+
+// Decodes one frame and returns the payloads it found
+using DecodeFunction = std::function<std::vector<std::string>(const CorpusSample&)>;
+
+static double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) return 0.0;
+    size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Shared measurement loop: cycles through the category's frames and turns the
+// per-frame timings and scores into counters
+static void runDecodeBenchmark(benchmark::State& state, const std::vector<const CorpusSample*>& samples,
+                               const DecodeFunction& decode) {
+    std::vector<double> latencies_ms;
+    latencies_ms.reserve(static_cast<size_t>(state.max_iterations));
+    int expected = 0;
+    int matched = 0;
+    int false_positives = 0;
+    size_t next = 0;
+
+    size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        const CorpusSample& sample = *samples[next];
+        next = (next + 1) % samples.size();
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::string> decoded = decode(sample);
+        auto end = std::chrono::steady_clock::now();
+
+        latencies_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        benchmark::DoNotOptimize(decoded.data());
+
+        // Scoring allocates too, keep it out of the counter
+        state.PauseTiming();
+        size_t allocations_decode = allocation_count.load(std::memory_order_relaxed);
+        DecodeScore score = scoreDecodes(sample, decoded);
+        expected += score.expected;
+        matched += score.matched;
+        false_positives += score.false_positives;
+        allocation_count.store(allocations_decode, std::memory_order_relaxed);
+        state.ResumeTiming();
+    }
+    size_t allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+
+    double frames = static_cast<double>(state.iterations());
+    state.SetItemsProcessed(state.iterations());
+    state.counters["p50_ms"] = percentile(latencies_ms, 0.50);
+    state.counters["p99_ms"] = percentile(latencies_ms, 0.99);
+    state.counters["allocs_per_frame"] = frames > 0 ? allocations / frames : 0.0;
+    state.counters["decode_rate"] = expected > 0 ? static_cast<double>(matched) / expected : 1.0;
+    state.counters["false_positives"] = frames > 0 ? false_positives / frames : 0.0;
+}
+
+// Library scanner configurations
+enum ScannerProfile {
+    PROFILE_SHIPPING_LABELS,  // configureScannerForShippingLabels(), inverted pass included
+    PROFILE_NO_INVERSION,     // Same symbologies, processWithColorInversion() takes the single pass
+    PROFILE_DATAMATRIX_ONLY   // Isolates the processDataMatrix() fallback
+};
+
+static std::shared_ptr<BarcodeScannerSettings> createProfileSettings(ScannerProfile profile) {
+    auto settings = createScannerSettings(PRESET_SINGLE_FRAME_MODE);
+    switch (profile) {
+        case PROFILE_SHIPPING_LABELS:
+            configureScannerForShippingLabels(settings);
+            break;
+        case PROFILE_NO_INVERSION:
+            configureScannerForShippingLabels(settings);
+            for (int i = 1; i < SYMBOLOGY_COUNT; ++i) {
+                settings->setColorInvertedEnabled(static_cast<SymbologyType>(i), false);
+            }
+            break;
+        case PROFILE_DATAMATRIX_ONLY:
+            settings->setSymbologyEnabled(SymbologyType::DataMatrix, true);
+            settings->setColorInvertedEnabled(SymbologyType::DataMatrix, true);
+            settings->setMaxCodesPerFrame(1);
+            settings->setSearchWholeImage(true);
+            break;
+    }
+    return settings;
+}
+
+static void BM_ProcessFrame(benchmark::State& state, ScannerProfile profile, std::string category) {
+    auto samples = samplesInCategory(category);
+    auto context = createRecognitionContext();
+    auto settings = createProfileSettings(profile);
+    BarcodeScanner scanner(context, settings);
+    context->startNewFrameSequence();
+
+    std::vector<BarcodeResult> results;
+    runDecodeBenchmark(state, samples, [&](const CorpusSample& sample) {
+        ImageDescription desc = createImageDescription(sample.image);
+        scanner.processFrame(desc, results);
+
+        std::vector<std::string> decoded;
+        for (const auto& result : results) decoded.emplace_back(result.data);
+        return decoded;
+    });
+
+    context->endFrameSequence();
+}
+
+// main.cpp's low-resolution chain on its own, on the CPU or the OpenCL
+// device (the CPU again when there is none)
+static void BM_PreprocessingChain(benchmark::State& state, std::string category, PreprocessDevice device) {
+    auto samples = samplesInCategory(category);
+    PreprocessingPipeline pipeline(defaultLowResolutionStages(), device);
+    cv::Mat gray;
+
+    runDecodeBenchmark(state, samples, [&](const CorpusSample& sample) {
+        cv::cvtColor(sample.image, gray, cv::COLOR_BGR2GRAY);
+        const cv::Mat& processed = pipeline.run(gray);
+        benchmark::DoNotOptimize(processed.data);
+        return std::vector<std::string>();
+    });
+}
+
+// The chain with only its denoise stage left in, one filter per run; the
+// skip threshold is off so every frame is filtered
+static void BM_Denoise(benchmark::State& state, std::string category, DenoiseMethod method) {
+    auto samples = samplesInCategory(category);
+    DenoiseOptions denoise = defaultDenoiseOptions();
+    denoise.method = method;
+    denoise.skip_below_sigma = 0;
+    PreprocessingPipeline pipeline({PREPROCESS_UPSCALE_2X, PREPROCESS_DENOISE}, PREPROCESS_DEVICE_CPU, denoise);
+    cv::Mat gray;
+
+    runDecodeBenchmark(state, samples, [&](const CorpusSample& sample) {
+        cv::cvtColor(sample.image, gray, cv::COLOR_BGR2GRAY);
+        const cv::Mat& processed = pipeline.run(gray);
+        benchmark::DoNotOptimize(processed.data);
+        return std::vector<std::string>();
+    });
+}
+
+// The pre-check that decides whether a frame is denoised at all
+static void BM_NoiseEstimate(benchmark::State& state, std::string category) {
+    auto samples = samplesInCategory(category);
+    cv::Mat gray;
+    cv::Mat scratch;
+
+    runDecodeBenchmark(state, samples, [&](const CorpusSample& sample) {
+        cv::cvtColor(sample.image, gray, cv::COLOR_BGR2GRAY);
+        benchmark::DoNotOptimize(estimateNoiseSigma(gray, scratch));
+        return std::vector<std::string>();
+    });
+}
+
+// Luma, inverted and half planes in one pass, against the OpenCV pass per plane
+static void BM_LumaPlanes(benchmark::State& state, std::string category, bool fused) {
+    auto samples = samplesInCategory(category);
+    LumaPlanes planes;
+    cv::Mat gray;
+    cv::Mat inverted;
+    cv::Mat half;
+
+    runDecodeBenchmark(state, samples, [&](const CorpusSample& sample) {
+        if (fused) {
+            extractLumaPlanes(sample.image, LUMA_PLANE_INVERTED | LUMA_PLANE_HALF, planes);
+            benchmark::DoNotOptimize(planes.half.data);
+        } else {
+            cv::cvtColor(sample.image, gray, cv::COLOR_BGR2GRAY);
+            cv::bitwise_not(gray, inverted);
+            cv::resize(gray, half, cv::Size(gray.cols / 2, gray.rows / 2), 0, 0, cv::INTER_AREA);
+            benchmark::DoNotOptimize(half.data);
+        }
+        return std::vector<std::string>();
+    });
+}
+
+// main.cpp's ZXing path: the chain followed by the 1.0 / 1.5 / 2.0 scale loop
+static void BM_MultiScaleZXing(benchmark::State& state, std::string category) {
+    auto samples = samplesInCategory(category);
+    PreprocessingPipeline pipeline(defaultLowResolutionStages());
+    ZXing::ReaderOptions options;
+    options.setTryHarder(true);
+    options.setTryRotate(true);
+    options.setTryInvert(true);
+    options.setMaxNumberOfSymbols(10);
+    cv::Mat gray;
+    cv::Mat scaled;
+
+    runDecodeBenchmark(state, samples, [&](const CorpusSample& sample) {
+        cv::cvtColor(sample.image, gray, cv::COLOR_BGR2GRAY);
+        const cv::Mat& processed = pipeline.run(gray);
+
+        std::vector<std::string> decoded;
+        for (double scale : {1.0, 1.5, 2.0}) {
+            if (scale != 1.0) {
+                cv::resize(processed, scaled, cv::Size(), scale, scale, cv::INTER_LINEAR);
+            } else {
+                scaled = processed;
+            }
+            ZXing::ImageView view(scaled.data, scaled.cols, scaled.rows, ZXing::ImageFormat::Lum,
+                                  static_cast<int>(scaled.step));
+            for (const auto& barcode : ZXing::ReadBarcodes(view, options)) {
+                if (barcode.isValid()) decoded.push_back(barcode.text());
+            }
+        }
+        return decoded;
+    });
+}
+
+// One decoder backend on the raw gray frame, the measurements behind
+// defaultEngineRoute(): each engine is limited to the symbologies the route
+// could hand it, so 1D and DataMatrix pairs compare like for like
+static const SymbologyMask BENCH_1D_SYMBOLOGIES = symbologyBit(SymbologyType::Code128) |
+                                                  symbologyBit(SymbologyType::Code39) |
+                                                  symbologyBit(SymbologyType::EAN13) |
+                                                  symbologyBit(SymbologyType::EAN8) | symbologyBit(SymbologyType::UPCA);
+
+static void BM_Engine(benchmark::State& state, DecoderEngine engine, SymbologyMask symbologies, std::string category) {
+    auto samples = samplesInCategory(category);
+    std::unique_ptr<DecoderBackend> backend = createDecoderBackend(engine);
+    if (!backend) {
+        state.SkipWithError("Engine not compiled in");
+        return;
+    }
+
+    auto settings = createScannerSettings(PRESET_SINGLE_FRAME_MODE);
+    for (int i = 1; i < SYMBOLOGY_COUNT; ++i) {
+        SymbologyType symbology = static_cast<SymbologyType>(i);
+        if (!(symbologies & symbologyBit(symbology))) continue;
+        settings->setSymbologyEnabled(symbology, true);
+        settings->setEngineRoute(symbology, {engine});
+    }
+    settings->setMaxCodesPerFrame(10);
+    settings->setTryHarderMode(true);
+    // Same per-frame bound for every engine, libdmtx would search on otherwise
+    settings->setFrameBudget(DEFAULT_REALTIME_FRAME_BUDGET);
+    auto plan = settings->compileDecoderPlan();
+    backend->configure(*plan);
+
+    FrameBufferPool buffers;
+    std::shared_ptr<BarcodeTextArena> text;
+    std::vector<DecodeCandidate> candidates;
+    std::vector<BarcodeResult> results;
+    cv::Mat gray;
+
+    runDecodeBenchmark(state, samples, [&](const CorpusSample& sample) {
+        cv::cvtColor(sample.image, gray, cv::COLOR_BGR2GRAY);
+        results.clear();
+        candidates.clear();
+        BarcodeTextArena::recycle(text);
+        FrameDeadline deadline(plan->frame_budget);
+
+        DecodeRequest request;
+        request.image = gray;
+        request.to_frame = 1.0;
+        request.symbologies = plan->engine_symbologies[engine];
+        request.is_inverted = false;
+        request.max_codes = plan->max_codes_per_frame;
+        request.plan = plan.get();
+        request.deadline = &deadline;
+        request.token = nullptr;
+        request.candidates = &candidates;
+        request.buffers = &buffers;
+        request.text = text;
+        request.instrumentation = ScanInstrumentation{nullptr, nullptr};
+        backend->decode(request, results);
+
+        std::vector<std::string> decoded;
+        for (const auto& result : results) decoded.emplace_back(result.data);
+        return decoded;
+    });
+}
+
+int main(int argc, char** argv) {
+    // Setup messages would otherwise interleave with the report
+    BarcodeLogger::instance().setLevel(LOG_LEVEL_WARNING);
+
+    const struct {
+        const char* name;
+        ScannerProfile profile;
+    } profiles[] = {
+        {"ShippingLabels", PROFILE_SHIPPING_LABELS},
+        {"NoInversion", PROFILE_NO_INVERSION},
+        {"DataMatrixOnly", PROFILE_DATAMATRIX_ONLY},
+    };
+
+    const struct {
+        const char* name;
+        DecoderEngine engine;
+        SymbologyMask symbologies;
+    } engines[] = {
+        {"ZBar1D", ENGINE_ZBAR, BENCH_1D_SYMBOLOGIES},
+        {"ZXing1D", ENGINE_ZXING, BENCH_1D_SYMBOLOGIES},
+        {"ZXingDataMatrix", ENGINE_ZXING, symbologyBit(SymbologyType::DataMatrix)},
+        {"libdmtx", ENGINE_LIBDMTX, symbologyBit(SymbologyType::DataMatrix)},
+    };
+
+    for (const std::string& category : corpusCategories(corpus())) {
+        for (const auto& profile : profiles) {
+            benchmark::RegisterBenchmark(("BM_ProcessFrame/" + std::string(profile.name) + "/" + category).c_str(),
+                                         BM_ProcessFrame, profile.profile, category)
+                ->Unit(benchmark::kMillisecond);
+        }
+        benchmark::RegisterBenchmark(("BM_PreprocessingChain/CPU/" + category).c_str(), BM_PreprocessingChain, category,
+                                     PREPROCESS_DEVICE_CPU)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("BM_PreprocessingChain/OpenCL/" + category).c_str(), BM_PreprocessingChain, category,
+                                     PREPROCESS_DEVICE_OPENCL)
+            ->Unit(benchmark::kMillisecond);
+        const std::pair<const char*, DenoiseMethod> denoisers[] = {
+            {"NLMeans", DENOISE_NL_MEANS}, {"Bilateral", DENOISE_BILATERAL}, {"Median", DENOISE_MEDIAN}, {"Box", DENOISE_BOX},
+        };
+        for (const auto& denoiser : denoisers) {
+            benchmark::RegisterBenchmark(("BM_Denoise/" + std::string(denoiser.first) + "/" + category).c_str(), BM_Denoise,
+                                         category, denoiser.second)
+                ->Unit(benchmark::kMillisecond);
+        }
+        benchmark::RegisterBenchmark(("BM_NoiseEstimate/" + category).c_str(), BM_NoiseEstimate, category)
+            ->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark(("BM_MultiScaleZXing/" + category).c_str(), BM_MultiScaleZXing, category)
+            ->Unit(benchmark::kMillisecond);
+        for (const auto& engine : engines) {
+            benchmark::RegisterBenchmark(("BM_Engine/" + std::string(engine.name) + "/" + category).c_str(),
+                                         BM_Engine, engine.engine, engine.symbologies, category)
+                ->Unit(benchmark::kMillisecond);
+        }
+        benchmark::RegisterBenchmark(("BM_LumaPlanes/Fused/" + category).c_str(), BM_LumaPlanes, category, true)
+            ->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark(("BM_LumaPlanes/OpenCV/" + category).c_str(), BM_LumaPlanes, category, false)
+            ->Unit(benchmark::kMicrosecond);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,248 @@
+// Accuracy/throughput regression harness over the benchmark corpus.
+//
+// Runs every frame through each scanner configuration below and reports,
+// per symbology and resolution bucket:
+//   read_rate  ground-truth payloads found / payloads expected
+//   fp/frame   decodes per frame that match no expected payload
+//   cpu_ms     process CPU time per frame, worker threads included
+// Rows marked '*' are on the Pareto front of their group: no other
+// configuration reads as much with as few false positives for less CPU.
+// Blank frames form the "none" group, which only has false positives.
+//
+// Usage: barcode_regression [--repeat N] [--csv]
+// Uses the same corpus as barcode_bench, see BARCODE_BENCH_CORPUS.
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench_corpus.h"
+#include "../barcode_decoder_backend.h"
+#include "../barcode_logger.h"
+#include "../barcode_preprocessing.h"
+#include "../barcode_scanner_lib.h"
+
+// One named way of setting up the scanner
+struct HarnessConfig {
+    std::string name;
+    std::function<void(std::shared_ptr<BarcodeScannerSettings>)> configure;
+};
+
+// main.cpp's configureScannerForLowResolution() before any variation
+static void configureLowResolution(std::shared_ptr<BarcodeScannerSettings> settings) {
+    settings->setEnabledSymbologyMask(LOW_RESOLUTION_SYMBOLOGIES);
+    settings->setColorInvertedMask(LOW_RESOLUTION_SYMBOLOGIES);
+    settings->setMaxCodesPerFrame(20);
+    settings->setSearchWholeImage(true);
+    settings->setTryHarderMode(true);
+    settings->setPreprocessingStages(defaultLowResolutionStages());
+}
+
+static std::vector<HarnessConfig> harnessConfigs() {
+    std::vector<HarnessConfig> configs;
+
+    // scan_main.cpp's single-image path
+    configs.push_back({"scan_reader", configureScannerForShippingLabels});
+
+    // main.cpp and the preprocessing variations worth deploying
+    configs.push_back({"barcode_reader", configureLowResolution});
+    configs.push_back({"barcode_reader/no_chain", [](std::shared_ptr<BarcodeScannerSettings> settings) {
+        configureLowResolution(settings);
+        settings->setPreprocessingStages({});
+    }});
+    configs.push_back({"barcode_reader/chain_always", [](std::shared_ptr<BarcodeScannerSettings> settings) {
+        configureLowResolution(settings);
+        settings->setPreprocessingEscalation(false);
+    }});
+    configs.push_back({"barcode_reader/always_denoise", [](std::shared_ptr<BarcodeScannerSettings> settings) {
+        configureLowResolution(settings);
+        DenoiseOptions denoise = defaultDenoiseOptions();
+        denoise.skip_below_sigma = 0;
+        settings->setDenoiseOptions(denoise);
+    }});
+    const std::pair<const char*, DenoiseMethod> denoisers[] = {
+        {"bilateral", DENOISE_BILATERAL}, {"median", DENOISE_MEDIAN}, {"box", DENOISE_BOX},
+    };
+    for (const auto& denoiser : denoisers) {
+        DenoiseMethod method = denoiser.second;
+        auto configure = [method](std::shared_ptr<BarcodeScannerSettings> settings) {
+            configureLowResolution(settings);
+            DenoiseOptions denoise = defaultDenoiseOptions();
+            denoise.method = method;
+            settings->setDenoiseOptions(denoise);
+        };
+        configs.push_back({std::string("barcode_reader/") + denoiser.first, configure});
+    }
+
+    // Every engine on its own, for the symbologies it can read
+    for (int i = 0; i < ENGINE_COUNT; ++i) {
+        DecoderEngine engine = static_cast<DecoderEngine>(i);
+        SymbologyMask symbologies = LOW_RESOLUTION_SYMBOLOGIES & getEngineSymbologies(engine);
+        if (!symbologies) continue;
+        auto configure = [engine, symbologies](std::shared_ptr<BarcodeScannerSettings> settings) {
+            configureLowResolution(settings);
+            settings->setPreprocessingStages({});
+            settings->setEnabledSymbologyMask(symbologies);
+            settings->setColorInvertedMask(symbologies);
+            for (int s = 1; s < SYMBOLOGY_COUNT; ++s) {
+                SymbologyType symbology = static_cast<SymbologyType>(s);
+                if (symbologies & symbologyBit(symbology)) settings->setEngineRoute(symbology, {engine});
+            }
+        };
+        configs.push_back({std::string("engine/") + getEngineName(engine), configure});
+    }
+
+    return configs;
+}
+
+static SymbologyType findSymbology(const std::string& name) {
+    for (int i = 1; i < SYMBOLOGY_COUNT; ++i) {
+        SymbologyType symbology = static_cast<SymbologyType>(i);
+        if (getSymbologyName(symbology) == name) return symbology;
+    }
+    return SymbologyType::None;
+}
+
+static std::string resolutionBucket(const cv::Mat& image) {
+    double megapixels = image.total() / 1e6;
+    if (megapixels <= 0.35) return "<=0.3MP";
+    if (megapixels <= 2.1) return "<=2MP";
+    if (megapixels <= 8.3) return "<=8MP";
+    return ">8MP";
+}
+
+struct GroupScore {
+    int frames = 0;
+    int expected = 0;
+    int matched = 0;
+    int false_positives = 0;
+    double cpu_ms = 0;
+
+    double readRate() const { return expected > 0 ? static_cast<double>(matched) / expected : 1.0; }
+    double falsePositivesPerFrame() const { return frames > 0 ? static_cast<double>(false_positives) / frames : 0.0; }
+    double cpuPerFrame() const { return frames > 0 ? cpu_ms / frames : 0.0; }
+};
+
+// Symbology then resolution bucket
+using GroupKey = std::pair<std::string, std::string>;
+
+static std::map<GroupKey, GroupScore> runConfig(const HarnessConfig& config, const std::vector<CorpusSample>& corpus,
+                                                int repeat) {
+    auto context = createRecognitionContext();
+    auto settings = createScannerSettings(PRESET_SINGLE_FRAME_MODE);
+    config.configure(settings);
+    BarcodeScanner scanner(context, settings);
+    context->startNewFrameSequence();
+    SymbologyMask enabled = settings->getEnabledSymbologyMask();
+
+    std::map<GroupKey, GroupScore> groups;
+    std::vector<BarcodeResult> results;
+    // First frame of a scanner sizes its buffers, keep it out of the timings
+    if (!corpus.empty()) scanner.processFrame(createImageDescription(corpus[0].image), results);
+
+    for (int pass = 0; pass < repeat; ++pass) {
+        for (const CorpusSample& sample : corpus) {
+            // A configuration without the symbology cannot be compared on it
+            SymbologyType symbology = findSymbology(sample.symbology);
+            if (symbology != SymbologyType::None && !(enabled & symbologyBit(symbology))) continue;
+
+            ImageDescription desc = createImageDescription(sample.image);
+            std::clock_t start = std::clock();
+            scanner.processFrame(desc, results);
+            std::clock_t end = std::clock();
+
+            std::vector<std::string> decoded;
+            for (const auto& result : results) decoded.emplace_back(result.data);
+            DecodeScore score = scoreDecodes(sample, decoded);
+
+            GroupScore& group = groups[GroupKey(sample.symbology.empty() ? "none" : sample.symbology,
+                                                resolutionBucket(sample.image))];
+            ++group.frames;
+            group.expected += score.expected;
+            group.matched += score.matched;
+            group.false_positives += score.false_positives;
+            group.cpu_ms += 1000.0 * (end - start) / CLOCKS_PER_SEC;
+        }
+    }
+
+    context->endFrameSequence();
+    return groups;
+}
+
+static bool dominates(const GroupScore& a, const GroupScore& b) {
+    bool no_worse = a.readRate() >= b.readRate() && a.falsePositivesPerFrame() <= b.falsePositivesPerFrame() &&
+                    a.cpuPerFrame() <= b.cpuPerFrame();
+    bool better = a.readRate() > b.readRate() || a.falsePositivesPerFrame() < b.falsePositivesPerFrame() ||
+                  a.cpuPerFrame() < b.cpuPerFrame();
+    return no_worse && better;
+}
+
+int main(int argc, char* argv[]) {
+    int repeat = 3;
+    bool csv = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--csv") {
+            csv = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--repeat N] [--csv]" << std::endl;
+            return 1;
+        }
+    }
+
+    BarcodeLogger::instance().setLevel(LOG_LEVEL_WARNING);
+    std::vector<CorpusSample> corpus = loadBenchCorpus();
+    std::vector<HarnessConfig> configs = harnessConfigs();
+
+    // Group, then one score per configuration that ran on it
+    std::map<GroupKey, std::vector<std::pair<std::string, GroupScore>>> table;
+    for (const HarnessConfig& config : configs) {
+        std::cerr << "Running " << config.name << std::endl;
+        for (const auto& group : runConfig(config, corpus, repeat)) {
+            table[group.first].push_back({config.name, group.second});
+        }
+    }
+
+    if (csv) std::cout << "symbology,resolution,config,frames,read_rate,fp_per_frame,cpu_ms_per_frame,pareto" << std::endl;
+    for (auto& group : table) {
+        auto& rows = group.second;
+        std::sort(rows.begin(), rows.end(), [](const std::pair<std::string, GroupScore>& a,
+                                               const std::pair<std::string, GroupScore>& b) {
+            return a.second.cpuPerFrame() < b.second.cpuPerFrame();
+        });
+
+        if (!csv) {
+            std::cout << "\n" << group.first.first << " " << group.first.second << "\n";
+            std::cout << "  " << std::left << std::setw(32) << "config" << std::right << std::setw(8) << "frames"
+                      << std::setw(11) << "read_rate" << std::setw(10) << "fp/frame" << std::setw(10) << "cpu_ms" << "\n";
+        }
+        for (const auto& row : rows) {
+            bool pareto = std::none_of(rows.begin(), rows.end(), [&row](const std::pair<std::string, GroupScore>& other) {
+                return dominates(other.second, row.second);
+            });
+            const GroupScore& score = row.second;
+            if (csv) {
+                std::cout << group.first.first << "," << group.first.second << "," << row.first << "," << score.frames
+                          << "," << score.readRate() << "," << score.falsePositivesPerFrame() << ","
+                          << score.cpuPerFrame() << "," << (pareto ? 1 : 0) << "\n";
+            } else {
+                std::cout << (pareto ? "* " : "  ") << std::left << std::setw(32) << row.first << std::right
+                          << std::setw(8) << score.frames << std::fixed << std::setprecision(3) << std::setw(11)
+                          << score.readRate() << std::setw(10) << score.falsePositivesPerFrame() << std::setprecision(2)
+                          << std::setw(10) << score.cpuPerFrame() << "\n";
+                std::cout.unsetf(std::ios::fixed);
+            }
+        }
+    }
+    std::cout.flush();
+    return 0;
+}
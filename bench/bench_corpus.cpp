@@ -0,0 +1,195 @@
+#include "bench_corpus.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <ZXing/BitMatrix.h>
+#include <ZXing/MultiFormatWriter.h>
+
+// Module-exact rendering, scaled up with nearest neighbour so edges stay sharp
+static cv::Mat renderBarcode(ZXing::BarcodeFormat format, const std::string& text, int width, int height) {
+    ZXing::BitMatrix bits = ZXing::MultiFormatWriter(format).setMargin(2).encode(text, 0, 0);
+    ZXing::Matrix<uint8_t> pixels = ZXing::ToMatrix<uint8_t>(bits);
+    cv::Mat modules(pixels.height(), pixels.width(), CV_8UC1, const_cast<uint8_t*>(pixels.data()));
+
+    cv::Mat rendered;
+    cv::resize(modules, rendered, cv::Size(width, height), 0, 0, cv::INTER_NEAREST);
+    return rendered;
+}
+
+// Label on a light, slightly noisy background; an empty barcode gives a blank frame
+static cv::Mat composeFrame(const cv::Mat& barcode, cv::Size frame_size, cv::Point origin, double noise_sigma) {
+    cv::Mat frame(frame_size, CV_8UC1, cv::Scalar(225));
+    if (!barcode.empty()) {
+        barcode.copyTo(frame(cv::Rect(origin, barcode.size())));
+    }
+
+    if (noise_sigma > 0) {
+        cv::Mat noise(frame_size, CV_16SC1);
+        cv::randn(noise, cv::Scalar::all(0), cv::Scalar::all(noise_sigma));
+        cv::Mat noisy;
+        frame.convertTo(noisy, CV_16SC1);
+        noisy += noise;
+        noisy.convertTo(frame, CV_8UC1);
+    }
+
+    cv::Mat bgr;
+    cv::cvtColor(frame, bgr, cv::COLOR_GRAY2BGR);
+    return bgr;
+}
+
+static CorpusSample makeSample(const std::string& name, const std::string& category, const std::string& symbology,
+                               cv::Mat image, std::vector<std::string> expected) {
+    CorpusSample sample;
+    sample.name = name;
+    sample.category = category;
+    sample.symbology = symbology;
+    sample.image = image;
+    sample.expected = std::move(expected);
+    return sample;
+}
+
+std::vector<CorpusSample> generateSyntheticCorpus() {
+    struct Label {
+        const char* name;
+        const char* symbology;
+        ZXing::BarcodeFormat format;
+        const char* text;
+        cv::Size size;  // Rendered size at full resolution
+    };
+    const Label labels[] = {
+        {"code128", "Code128", ZXing::BarcodeFormat::Code128, "SHIP-0042-XYZ", cv::Size(420, 120)},
+        {"ean13", "EAN13", ZXing::BarcodeFormat::EAN13, "5901234123457", cv::Size(300, 120)},
+        {"datamatrix", "DataMatrix", ZXing::BarcodeFormat::DataMatrix, "(01)09501101530003(17)250101(10)AB12",
+         cv::Size(160, 160)},
+        {"qr", "QRCode", ZXing::BarcodeFormat::QRCode, "https://example.com/track/123456", cv::Size(200, 200)},
+    };
+
+    // Fixed placement and noise so runs are comparable
+    std::vector<CorpusSample> corpus;
+    cv::RNG rng(12345);
+    cv::theRNG().state = 12345;
+
+    for (const Label& label : labels) {
+        cv::Mat barcode = renderBarcode(label.format, label.text, label.size.width, label.size.height);
+
+        // Camera frame size, a few positions per label
+        const cv::Size vga(640, 480);
+        for (int i = 0; i < 3; ++i) {
+            cv::Point origin(rng.uniform(0, vga.width - label.size.width),
+                             rng.uniform(0, vga.height - label.size.height));
+            corpus.push_back(makeSample(std::string(label.name) + "_vga_" + std::to_string(i), label.name, label.symbology,
+                                        composeFrame(barcode, vga, origin, 6.0), {label.text}));
+        }
+
+        // Same label at 40% of the size, the low-resolution path
+        cv::Mat small;
+        cv::resize(barcode, small, cv::Size(), 0.4, 0.4, cv::INTER_AREA);
+        corpus.push_back(makeSample(std::string(label.name) + "_lowres", "lowres", label.symbology,
+                                    composeFrame(small, cv::Size(320, 240), cv::Point(20, 20), 4.0), {label.text}));
+
+        // Light bars on a dark label
+        cv::Mat inverted;
+        cv::bitwise_not(composeFrame(barcode, vga, cv::Point(40, 40), 6.0), inverted);
+        corpus.push_back(makeSample(std::string(label.name) + "_inverted", "inverted", label.symbology, inverted,
+                                    {label.text}));
+    }
+
+    // A large frame where the label covers a small part of the pixels
+    {
+        cv::Mat barcode = renderBarcode(ZXing::BarcodeFormat::Code128, "PALLET-7781-0001", 600, 160);
+        corpus.push_back(makeSample("code128_12mp", "highres", "Code128",
+                                    composeFrame(barcode, cv::Size(4000, 3000), cv::Point(2700, 2100), 6.0),
+                                    {"PALLET-7781-0001"}));
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        corpus.push_back(makeSample("blank_" + std::to_string(i), "blank", "",
+                                    composeFrame(cv::Mat(), cv::Size(640, 480), cv::Point(0, 0), 8.0),
+                                    {}));
+    }
+
+    return corpus;
+}
+
+static std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+std::vector<CorpusSample> loadCorpusDirectory(const std::string& dir) {
+    std::ifstream manifest(dir + "/manifest.csv");
+    if (!manifest) {
+        throw std::runtime_error("Could not open " + dir + "/manifest.csv");
+    }
+
+    std::vector<CorpusSample> corpus;
+    std::string line;
+    while (std::getline(manifest, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::vector<std::string> fields = split(line, ',');
+        if (fields.size() < 2) {
+            throw std::runtime_error("Malformed manifest line: " + line);
+        }
+
+        cv::Mat image = cv::imread(dir + "/" + fields[0], cv::IMREAD_COLOR);
+        if (image.empty()) {
+            throw std::runtime_error("Could not read " + dir + "/" + fields[0]);
+        }
+
+        std::vector<std::string> expected;
+        if (fields.size() > 2 && !fields[2].empty()) {
+            expected = split(fields[2], '|');
+        }
+        std::string symbology = fields.size() > 3 ? fields[3] : std::string();
+        corpus.push_back(makeSample(fields[0], fields[1], symbology, image, expected));
+    }
+
+    return corpus;
+}
+
+std::vector<CorpusSample> loadBenchCorpus() {
+    const char* dir = std::getenv("BARCODE_BENCH_CORPUS");
+    if (dir && *dir) {
+        return loadCorpusDirectory(dir);
+    }
+    return generateSyntheticCorpus();
+}
+
+std::vector<std::string> corpusCategories(const std::vector<CorpusSample>& corpus) {
+    std::vector<std::string> categories;
+    for (const auto& sample : corpus) {
+        if (std::find(categories.begin(), categories.end(), sample.category) == categories.end()) {
+            categories.push_back(sample.category);
+        }
+    }
+    return categories;
+}
+
+DecodeScore scoreDecodes(const CorpusSample& sample, const std::vector<std::string>& decoded) {
+    DecodeScore score;
+    score.expected = static_cast<int>(sample.expected.size());
+    score.matched = 0;
+    score.false_positives = 0;
+
+    for (const auto& payload : sample.expected) {
+        if (std::find(decoded.begin(), decoded.end(), payload) != decoded.end()) {
+            ++score.matched;
+        }
+    }
+    for (const auto& payload : decoded) {
+        if (std::find(sample.expected.begin(), sample.expected.end(), payload) == sample.expected.end()) {
+            ++score.false_positives;
+        }
+    }
+    return score;
+}
@@ -0,0 +1,43 @@
+#ifndef BENCH_CORPUS_H
+#define BENCH_CORPUS_H
+
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// One labelled frame. Blank frames have no expected payloads.
+struct CorpusSample {
+    std::string name;
+    std::string category;                // Benchmarks run once per category
+    std::string symbology;               // getSymbologyName() of the labels, empty for blank or unknown
+    cv::Mat image;                       // BGR, as a camera or imread() delivers it
+    std::vector<std::string> expected;   // Ground-truth payloads
+};
+
+// Frames rendered with ZXing's writers so the corpus needs no checked-in
+// images: Code128, EAN13, DataMatrix and QR labels at low and full
+// resolution, inverted labels, and blank frames with sensor noise.
+std::vector<CorpusSample> generateSyntheticCorpus();
+
+// Reads <dir>/manifest.csv with one "file,category,payload|payload[,symbology]"
+// line per image; lines starting with '#' are comments. Throws if the
+// manifest or an image cannot be read.
+std::vector<CorpusSample> loadCorpusDirectory(const std::string& dir);
+
+// The directory in $BARCODE_BENCH_CORPUS if set, the synthetic corpus otherwise
+std::vector<CorpusSample> loadBenchCorpus();
+
+// Categories in first-seen order
+std::vector<std::string> corpusCategories(const std::vector<CorpusSample>& corpus);
+
+// Ground-truth payloads found in decoded, and decodes that match none
+struct DecodeScore {
+    int expected;
+    int matched;
+    int false_positives;
+};
+
+DecodeScore scoreDecodes(const CorpusSample& sample, const std::vector<std::string>& decoded);
+
+#endif // BENCH_CORPUS_H
@@ -3,17 +3,86 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <iomanip>
+#include <cstdlib>
+#include <string>
 
+#include "barcode_batch.h"
+#include "barcode_image_writer.h"
+#include "barcode_logger.h"
 #include "barcode_scanner_lib.h"
 
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--headless] <image_path>" << std::endl;
+    std::cout << "       " << program << " --batch <dir|manifest> [--workers N] [--loaders N] [--reduce 1|2|4|8]" << std::endl;
+    std::cout << "Professional barcode scanner inspired by Scandit SDK" << std::endl;
+}
+
+// No window can be opened, so the overlay and the preview are skipped
+static bool isHeadless() {
+#if defined(__linux__)
+    return !std::getenv("DISPLAY") && !std::getenv("WAYLAND_DISPLAY");
+#else
+    return false;
+#endif
+}
+
+// Scans a directory or manifest with one scanner pool and writes JSON Lines
+// to stdout; log messages go to stderr so the output stays parseable
+static int runBatch(int argc, char *argv[]) {
+    BarcodeLogger::instance().setSink(std::make_shared<ConsoleLogSink>(std::cerr));
+    
+    std::string input = argv[2];
+    BatchScanOptions options = defaultBatchScanOptions();
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        unsigned long value = std::strtoul(argv[i + 1], nullptr, 10);
+        if (flag == "--workers") {
+            options.decode_workers = value;
+        } else if (flag == "--loaders") {
+            options.loader_threads = value;
+        } else if (flag == "--reduce") {
+            options.reduction = static_cast<int>(value);
+        } else {
+            std::cerr << "Unknown option: " << flag << std::endl;
+            return 1;
+        }
+    }
+    if ((argc - 3) % 2 != 0) {
+        std::cerr << "Missing value for " << argv[argc - 1] << std::endl;
+        return 1;
+    }
+    
+    try {
+        auto recognition_context = createRecognitionContext();
+        auto scanner_settings = createScannerSettings();
+        configureScannerForShippingLabels(scanner_settings);
+        
+        std::vector<std::string> paths = listBatchInputs(input);
+        BarcodeBatchScanner batch(recognition_context, scanner_settings, options);
+        size_t with_codes = batch.run(paths, std::cout);
+        std::cerr << with_codes << " of " << paths.size() << " file(s) had barcodes" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <image_path>" << std::endl;
-        std::cout << "Professional barcode scanner inspired by Scandit SDK" << std::endl;
+    if (argc >= 3 && std::string(argv[1]) == "--batch") {
+        return runBatch(argc, argv);
+    }
+    
+    bool headless = isHeadless();
+    if (argc == 3 && std::string(argv[1]) == "--headless") {
+        headless = true;
+    } else if (argc != 2) {
+        printUsage(argv[0]);
         return 1;
     }
     
-    std::string image_path = argv[1];
+    std::string image_path = argv[argc - 1];
     
     std::cout << "=== PROFESSIONAL BARCODE SCANNER ===" << std::endl;
     std::cout << "Scandit-inspired architecture with ZXing + libdmtx" << std::endl;
@@ -68,7 +137,12 @@ int main(int argc, char *argv[]) {
         // Step 9: Handle results
         std::cout << "\n=== SCAN RESULTS ===" << std::endl;
         
-        if (result == ScanStatus::SCAN_SUCCESS) {
+        if (result == ScanStatus::SCAN_PARTIAL_BUDGET_EXHAUSTED) {
+            std::cout << "Frame budget exhausted, results may be incomplete" << std::endl;
+        }
+        
+        if (result == ScanStatus::SCAN_SUCCESS ||
+            (result == ScanStatus::SCAN_PARTIAL_BUDGET_EXHAUSTED && !scanner->getLastScanResults().empty())) {
             const auto& results = scanner->getLastScanResults();
             
             std::cout << "Successfully found " << results.size() << " barcode(s):" << std::endl;
@@ -78,7 +152,7 @@ int main(int argc, char *argv[]) {
                 std::cout << "\n📦 Barcode " << i + 1 << ":" << std::endl;
                 std::cout << "  Type: " << barcode.symbology_name << std::endl;
                 std::cout << "  Data: " << barcode.data << std::endl;
-                std::cout << "  Format Details:\n" << barcode.format_details << std::endl;
+                std::cout << "  Format Details:\n" << barcode.formatDetails() << std::endl;
                 std::cout << "  Location: (" << barcode.location.x << "," << barcode.location.y 
                          << ") " << barcode.location.width << "x" << barcode.location.height << std::endl;
                 std::cout << "  Color Inverted: " << (barcode.is_color_inverted ? "Yes" : "No") << std::endl;
@@ -110,68 +184,72 @@ int main(int argc, char *argv[]) {
             std::cout << "2D Barcodes found: " << code2d.size() << std::endl;
             
             // Display the image with barcode locations
-            cv::Mat display_image = opencv_image.clone();
-            for (const auto& barcode : results) {
-                cv::Scalar color;
-                if (barcode.symbology == SymbologyType::DataMatrix || barcode.symbology == SymbologyType::QRCode || barcode.symbology == SymbologyType::Aztec || barcode.symbology == SymbologyType::PDF417) {
-                    // 2D Barcodes - Bright green rectangle and text
-                    color = cv::Scalar(0, 255, 0); // Bright green
-                    cv::rectangle(display_image, barcode.location, color, 4); // Increased thickness
+            if (!headless) {
+                cv::Mat display_image = opencv_image.clone();
+                for (const auto& barcode : results) {
+                    cv::Scalar color;
+                    if (barcode.symbology == SymbologyType::DataMatrix || barcode.symbology == SymbologyType::QRCode || barcode.symbology == SymbologyType::Aztec || barcode.symbology == SymbologyType::PDF417) {
+                        // 2D Barcodes - Bright green rectangle and text
+                        color = cv::Scalar(0, 255, 0); // Bright green
+                        cv::rectangle(display_image, barcode.location, color, 4); // Increased thickness
                     
-                    // Add text with background for better visibility
-                    std::string label = barcode.symbology_name;
-                    int baseline = 0;
-                    cv::Size text_size = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 1.0, 2, &baseline);
-                    cv::Point text_origin(barcode.location.x, barcode.location.y - 20);
+                        // Add text with background for better visibility
+                        std::string label(barcode.symbology_name);
+                        int baseline = 0;
+                        cv::Size text_size = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 1.0, 2, &baseline);
+                        cv::Point text_origin(barcode.location.x, barcode.location.y - 20);
                     
-                    // Draw text background
-                    cv::rectangle(display_image, 
-                                cv::Rect(text_origin.x, text_origin.y - text_size.height,
-                                        text_size.width, text_size.height + baseline),
-                                cv::Scalar(0, 0, 0), -1);
+                        // Draw text background
+                        cv::rectangle(display_image, 
+                                    cv::Rect(text_origin.x, text_origin.y - text_size.height,
+                                            text_size.width, text_size.height + baseline),
+                                    cv::Scalar(0, 0, 0), -1);
                     
-                    // Draw text
-                    cv::putText(display_image, label, text_origin,
-                               cv::FONT_HERSHEY_SIMPLEX, 1.0, color, 2);
-                } else {
-                    // 1D Barcodes - Red arrow and text
-                    color = cv::Scalar(0, 0, 255); // Red
+                        // Draw text
+                        cv::putText(display_image, label, text_origin,
+                                   cv::FONT_HERSHEY_SIMPLEX, 1.0, color, 2);
+                    } else {
+                        // 1D Barcodes - Red arrow and text
+                        color = cv::Scalar(0, 0, 255); // Red
                     
-                    // Calculate center of the 1D barcode for the arrow target
-                    cv::Point barcode_center(barcode.location.x + barcode.location.width / 2, 
-                                             barcode.location.y + barcode.location.height / 2);
+                        // Calculate center of the 1D barcode for the arrow target
+                        cv::Point barcode_center(barcode.location.x + barcode.location.width / 2, 
+                                                 barcode.location.y + barcode.location.height / 2);
                     
-                    // Define start point for the arrow (e.g., 50 pixels above the barcode's top-left corner)
-                    cv::Point arrow_start(barcode.location.x, barcode.location.y - 50);
+                        // Define start point for the arrow (e.g., 50 pixels above the barcode's top-left corner)
+                        cv::Point arrow_start(barcode.location.x, barcode.location.y - 50);
 
-                    // Draw an arrow pointing to the 1D barcode
-                    cv::arrowedLine(display_image, arrow_start, barcode_center, color, 3, cv::LINE_8, 0, 0.1); // Increased thickness, adjusted tip length
+                        // Draw an arrow pointing to the 1D barcode
+                        cv::arrowedLine(display_image, arrow_start, barcode_center, color, 3, cv::LINE_8, 0, 0.1); // Increased thickness, adjusted tip length
                     
-                    // Add text with background for better visibility near the arrow start
-                    std::string label = barcode.symbology_name + ": " + barcode.data.substr(0, std::min((int)barcode.data.length(), 20)) + "...";
-                    int baseline = 0;
-                    cv::Size text_size = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.8, 2, &baseline); // Slightly smaller font for 1D labels
-                    cv::Point text_origin(arrow_start.x, arrow_start.y - 10); // Position text above the arrow start
+                        // Add text with background for better visibility near the arrow start
+                        std::string label = std::string(barcode.symbology_name) + ": " + std::string(barcode.data.substr(0, 20)) + "...";
+                        int baseline = 0;
+                        cv::Size text_size = cv::getTextSize(label, cv::FONT_HERSHEY_SIMPLEX, 0.8, 2, &baseline); // Slightly smaller font for 1D labels
+                        cv::Point text_origin(arrow_start.x, arrow_start.y - 10); // Position text above the arrow start
                     
-                    // Draw text background
-                    cv::rectangle(display_image, 
-                                cv::Rect(text_origin.x, text_origin.y - text_size.height,
-                                        text_size.width, text_size.height + baseline),
-                                cv::Scalar(0, 0, 0), -1);
+                        // Draw text background
+                        cv::rectangle(display_image, 
+                                    cv::Rect(text_origin.x, text_origin.y - text_size.height,
+                                            text_size.width, text_size.height + baseline),
+                                    cv::Scalar(0, 0, 0), -1);
                     
-                    // Draw text
-                    cv::putText(display_image, label, text_origin,
-                               cv::FONT_HERSHEY_SIMPLEX, 0.8, color, 2);
+                        // Draw text
+                        cv::putText(display_image, label, text_origin,
+                                   cv::FONT_HERSHEY_SIMPLEX, 0.8, color, 2);
+                    }
                 }
-            }
             
-            // Show the image
-            cv::imshow("Barcode Detection Results", display_image);
-            cv::waitKey(0); // Keep window open indefinitely until a key is pressed
-            cv::destroyAllWindows();
-
-            // Save the image with drawn barcodes to a file
-            cv::imwrite("barcode_results.jpg", display_image);
+                // Save the image with drawn barcodes to a file; it is encoded
+                // on the writer thread while the window is open
+                AsyncImageWriter image_writer;
+                image_writer.submit(display_image, "barcode_results.jpg");
+                
+                // Show the image
+                cv::imshow("Barcode Detection Results", display_image);
+                cv::waitKey(0); // Keep window open indefinitely until a key is pressed
+                cv::destroyAllWindows();
+            }
             
         } else {
             switch (result) {
@@ -184,6 +262,9 @@ int main(int argc, char *argv[]) {
                 case ScanStatus::SCAN_INVALID_IMAGE:
                     std::cout << "Invalid image data" << std::endl;
                     break;
+                case ScanStatus::SCAN_PARTIAL_BUDGET_EXHAUSTED:
+                    std::cout << "No barcodes found within the frame budget" << std::endl;
+                    break;
                 default:
                     std::cout << "Unknown error occurred" << std::endl;
             }
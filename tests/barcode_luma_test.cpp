@@ -0,0 +1,154 @@
+// extractLumaPlanes() against scalar references, on row widths that end in
+// every vector kernel's tail and on strided views. Exits non-zero on the
+// first failed check.
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <opencv2/opencv.hpp>
+
+#include "../barcode_buffer_pool.h"
+#include "../barcode_luma.h"
+#include "../barcode_pyramid.h"
+#include "test_check.h"
+
+// Same fixed-point weights as cv::cvtColor's BGR2GRAY
+static cv::Mat referenceLuma(const cv::Mat& source) {
+    cv::Mat luma(source.rows, source.cols, CV_8UC1);
+    int channels = source.channels();
+    for (int y = 0; y < source.rows; ++y) {
+        const uint8_t* src = source.ptr(y);
+        uint8_t* dst = luma.ptr(y);
+        for (int x = 0; x < source.cols; ++x) {
+            const uint8_t* pixel = src + x * channels;
+            if (channels == 1 || channels == 2) {
+                dst[x] = pixel[0];
+            } else {
+                dst[x] = static_cast<uint8_t>((pixel[0] * 1868 + pixel[1] * 9617 + pixel[2] * 4899 + (1 << 13)) >> 14);
+            }
+        }
+    }
+    return luma;
+}
+
+static cv::Mat referenceHalf(const cv::Mat& luma) {
+    cv::Mat half(luma.rows / 2, luma.cols / 2, CV_8UC1);
+    for (int y = 0; y < half.rows; ++y) {
+        const uint8_t* row0 = luma.ptr(2 * y);
+        const uint8_t* row1 = luma.ptr(2 * y + 1);
+        for (int x = 0; x < half.cols; ++x) {
+            half.at<uint8_t>(y, x) = static_cast<uint8_t>(
+                (row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1] + 2) >> 2);
+        }
+    }
+    return half;
+}
+
+static bool equal(const cv::Mat& a, const cv::Mat& b) {
+    if (a.size() != b.size() || a.type() != b.type()) return false;
+    for (int y = 0; y < a.rows; ++y) {
+        if (std::memcmp(a.ptr(y), b.ptr(y), a.cols * a.elemSize()) != 0) return false;
+    }
+    return true;
+}
+
+static cv::Mat invert(const cv::Mat& luma) {
+    cv::Mat inverted(luma.rows, luma.cols, CV_8UC1);
+    for (int y = 0; y < luma.rows; ++y) {
+        for (int x = 0; x < luma.cols; ++x) inverted.at<uint8_t>(y, x) = static_cast<uint8_t>(255 - luma.at<uint8_t>(y, x));
+    }
+    return inverted;
+}
+
+// Every plane of source, in one call, against the references
+static void checkPlanes(const cv::Mat& source, LumaPlanes& planes) {
+    extractLumaPlanes(source, LUMA_PLANE_INVERTED | LUMA_PLANE_HALF, planes);
+    cv::Mat luma = referenceLuma(source);
+    CHECK(equal(planes.luma, luma));
+    CHECK(equal(planes.inverted, invert(luma)));
+    if (source.cols >= 2 && source.rows >= 2) {
+        CHECK(equal(planes.half, referenceHalf(luma)));
+    } else {
+        CHECK(planes.half.empty());
+    }
+}
+
+static void testKernelsMatchScalar() {
+    // Around the 8, 16, 19 and 32 pixel steps of the AVX2 and NEON kernels
+    const int widths[] = {1, 2, 7, 8, 15, 16, 17, 19, 31, 32, 33, 35, 63, 64, 65, 97};
+    const int heights[] = {1, 2, 3, 5, 8};
+    const int types[] = {CV_8UC1, CV_8UC2, CV_8UC3, CV_8UC4};
+    cv::RNG rng(12345);
+    LumaPlanes planes;
+
+    for (int type : types) {
+        for (int width : widths) {
+            for (int height : heights) {
+                cv::Mat dense(height, width, type);
+                rng.fill(dense, cv::RNG::UNIFORM, 0, 256);
+                checkPlanes(dense, planes);
+
+                // A view into a wider frame, so rows are not contiguous
+                cv::Mat frame(height + 3, width + 11, type);
+                rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+                checkPlanes(frame(cv::Rect(5, 2, width, height)), planes);
+            }
+        }
+    }
+}
+
+static void testMatchesOpenCv() {
+    cv::RNG rng(54321);
+    LumaPlanes planes;
+    for (int type : {CV_8UC3, CV_8UC4}) {
+        cv::Mat source(64, 130, type);
+        rng.fill(source, cv::RNG::UNIFORM, 0, 256);
+        extractLumaPlanes(source, LUMA_PLANE_HALF, planes);
+
+        cv::Mat gray, half;
+        cv::cvtColor(source, gray, type == CV_8UC3 ? cv::COLOR_BGR2GRAY : cv::COLOR_BGRA2GRAY);
+        cv::resize(gray, half, cv::Size(gray.cols / 2, gray.rows / 2), 0, 0, cv::INTER_AREA);
+        CHECK(equal(planes.luma, gray));
+        CHECK(equal(planes.half, half));
+        CHECK(planes.inverted.empty());
+    }
+}
+
+static void testGrayIsNotCopied() {
+    cv::Mat gray(32, 48, CV_8UC1, cv::Scalar(90));
+    LumaPlanes planes;
+    extractLumaPlanes(gray, 0, planes);
+    CHECK(planes.luma.data == gray.data);
+    CHECK(planes.inverted.empty());
+    CHECK(planes.half.empty());
+}
+
+static void testPyramidReusesHalfPlane() {
+    cv::Mat gray(60, 80, CV_8UC1);
+    cv::RNG(7).fill(gray, cv::RNG::UNIFORM, 0, 256);
+    LumaPlanes planes;
+    extractLumaPlanes(gray, LUMA_PLANE_HALF, planes);
+
+    FrameBufferPool pool;
+    ImagePyramid pyramid(pool);
+    pyramid.reset(gray, {0.5, 1.0, 2.0}, planes.half);
+    CHECK(pyramid.level(0).data == planes.half.data);
+    CHECK(pyramid.level(1).data == gray.data);
+    CHECK(pyramid.level(2).size() == cv::Size(160, 120));
+
+    // Without it the level is resized as before
+    pyramid.reset(gray, {0.5});
+    CHECK(pyramid.level(0).data != planes.half.data);
+    CHECK(equal(pyramid.level(0), planes.half));
+    pyramid.clear();
+}
+
+int main() {
+    std::cout << "Luma kernel: " << getLumaKernelName() << std::endl;
+    testKernelsMatchScalar();
+    testMatchesOpenCv();
+    testGrayIsNotCopied();
+    testPyramidReusesHalfPlane();
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
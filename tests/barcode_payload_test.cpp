@@ -0,0 +1,133 @@
+// Payload parsers in barcode_payload.h. Exits non-zero on the first failed
+// check.
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "../barcode_payload.h"
+#include "test_check.h"
+
+static void testGtinCheckDigits() {
+    GtinView gtin;
+    CHECK(parseGtin("4006381333931", gtin));  // EAN-13
+    CHECK(gtin.check_digit_valid);
+    CHECK(gtin.expected_check_digit == 1);
+    CHECK(parseGtin("036000291452", gtin));  // UPC-A
+    CHECK(gtin.check_digit_valid);
+    CHECK(parseGtin("96385074", gtin));  // EAN-8
+    CHECK(gtin.check_digit_valid);
+    CHECK(parseGtin("09501101530003", gtin));  // GTIN-14
+    CHECK(gtin.check_digit_valid);
+
+    CHECK(parseGtin("4006381333932", gtin));
+    CHECK(!gtin.check_digit_valid);
+    CHECK(gtin.expected_check_digit == 1);
+
+    CHECK(!parseGtin("40063813339", gtin));
+    CHECK(!parseGtin("40063813339a1", gtin));
+    CHECK(!parseGtin("", gtin));
+}
+
+// Collects "ai=value;" for every element, and whether parsing stopped early
+static std::string elements(std::string_view data, bool& failed) {
+    Gs1Tokenizer tokenizer(data);
+    std::string joined;
+    Gs1Element element;
+    while (tokenizer.next(element)) {
+        joined.append(element.ai).append("=").append(element.value).append(";");
+    }
+    failed = tokenizer.failed();
+    return joined;
+}
+
+static void testGs1Bracketed() {
+    bool failed = false;
+    const char* data = "(01)09501101530003(17)250101(10)AB12";
+    CHECK(detectPayloadKind(data) == PAYLOAD_GS1);
+    CHECK(elements(data, failed) == "01=09501101530003;17=250101;10=AB12;");
+    CHECK(!failed);
+
+    std::string_view batch;
+    CHECK(findGs1Element(data, "10", batch));
+    CHECK(batch == "AB12");
+    CHECK(!findGs1Element(data, "21", batch));
+
+    CHECK(detectPayloadKind("(3103)000189(00)123456789012345675") == PAYLOAD_GS1);
+    CHECK(detectPayloadKind("(99)internal") == PAYLOAD_GS1);
+}
+
+static void testGs1RejectsOrdinaryText() {
+    CHECK(detectPayloadKind("(555) 123-4567") == PAYLOAD_TEXT);
+    CHECK(detectPayloadKind("(01)123") == PAYLOAD_TEXT);       // AI 01 needs 14 digits
+    CHECK(detectPayloadKind("(01)09501101530003 (see box)") == PAYLOAD_TEXT);
+    CHECK(detectPayloadKind("(88)value") == PAYLOAD_TEXT);     // Not an AI
+    CHECK(detectPayloadKind("(1)2") == PAYLOAD_TEXT);
+    CHECK(!Gs1Tokenizer("(555) 123-4567").isGs1());
+
+    std::string_view value;
+    CHECK(!findGs1Element("(555) 123-4567", "555", value));
+}
+
+static void testGs1Raw() {
+    bool failed = false;
+    // Symbology identifier, predefined-length AIs without separators, GS after a variable-length value
+    std::string with_identifier = std::string("]d2") + "0109501101530003" + "17250101" + "10AB12" + "\x1d" + "21XYZ";
+    CHECK(detectPayloadKind(with_identifier) == PAYLOAD_GS1);
+    CHECK(elements(with_identifier, failed) == "01=09501101530003;17=250101;10=AB12;21=XYZ;");
+    CHECK(!failed);
+
+    // FNC1 in first position, and a redundant separator after a predefined-length element
+    std::string leading_fnc1 = std::string("\x1d") + "0109501101530003" + "\x1d" + "10ABC";
+    CHECK(elements(leading_fnc1, failed) == "01=09501101530003;10=ABC;");
+    CHECK(!failed);
+
+    // Truncated predefined-length value
+    std::string truncated = std::string("]C1") + "01095011015";
+    CHECK(elements(truncated, failed).empty());
+    CHECK(failed);
+
+    // Raw digits without an identifier or FNC1 are not GS1
+    CHECK(detectPayloadKind("0109501101530003") == PAYLOAD_TEXT);
+}
+
+static void testWifi() {
+    WifiView wifi;
+    CHECK(parseWifi("WIFI:S:Dock\\;Office;T:WPA;P:se\\:cret;H:true;;", wifi));
+    CHECK(wifi.ssid == "Dock\\;Office");
+    CHECK(wifi.security == "WPA");
+    CHECK(wifi.password == "se\\:cret");
+    CHECK(wifi.hidden);
+
+    CHECK(parseWifi("WIFI:T:nopass;S:Guest;;", wifi));
+    CHECK(wifi.ssid == "Guest");
+    CHECK(wifi.password.empty());
+    CHECK(!wifi.hidden);
+
+    CHECK(!parseWifi("wifi-S:Guest", wifi));
+    CHECK(detectPayloadKind("WIFI:S:Guest;;") == PAYLOAD_WIFI);
+}
+
+static void testVCard() {
+    VCardView vcard;
+    const char* data = "BEGIN:VCARD\r\nVERSION:3.0\r\nFN:Jane Doe\r\nTEL;TYPE=CELL:+1 555 0100\r\n"
+                       "TEL:+1 555 0199\r\nEMAIL:jane@example.com\r\nEND:VCARD";
+    CHECK(parseVCard(data, vcard));
+    CHECK(vcard.name == "Jane Doe");
+    CHECK(vcard.phone == "+1 555 0100");
+    CHECK(vcard.email == "jane@example.com");
+    CHECK(detectPayloadKind(data) == PAYLOAD_VCARD);
+
+    CHECK(!parseVCard("FN:Jane Doe", vcard));
+    CHECK(detectPayloadKind("https://example.com/track/1") == PAYLOAD_URL);
+}
+
+int main() {
+    testGtinCheckDigits();
+    testGs1Bracketed();
+    testGs1RejectsOrdinaryText();
+    testGs1Raw();
+    testWifi();
+    testVCard();
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,191 @@
+// Decode regressions that need no corpus: frames are rendered with ZXing's
+// writers. Exits non-zero on the first failed check.
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ZXing/BitMatrix.h>
+#include <ZXing/MultiFormatWriter.h>
+
+#include "../barcode_logger.h"
+#include "../barcode_scanner_c.h"
+#include "../barcode_scanner_lib.h"
+#include "test_check.h"
+
+static const char* const DATAMATRIX_TEXT = "(01)09501101530003(17)250101(10)AB12";
+
+// module_size pixels per module, placed at origin on a light background
+static cv::Mat renderFrame(ZXing::BarcodeFormat format, const std::string& text, int module_size, cv::Size frame_size,
+                           cv::Point origin, cv::Rect& placed) {
+    ZXing::BitMatrix bits = ZXing::MultiFormatWriter(format).setMargin(2).encode(text, 0, 0);
+    ZXing::Matrix<uint8_t> pixels = ZXing::ToMatrix<uint8_t>(bits);
+    cv::Mat modules(pixels.height(), pixels.width(), CV_8UC1, const_cast<uint8_t*>(pixels.data()));
+
+    cv::Mat barcode;
+    cv::resize(modules, barcode, cv::Size(), module_size, module_size, cv::INTER_NEAREST);
+    cv::Mat frame(frame_size, CV_8UC1, cv::Scalar(225));
+    placed = cv::Rect(origin, barcode.size());
+    barcode.copyTo(frame(placed));
+
+    cv::Mat bgr;
+    cv::cvtColor(frame, bgr, cv::COLOR_GRAY2BGR);
+    return bgr;
+}
+
+static std::vector<BarcodeResult> scan(const cv::Mat& frame, const EngineRoute& datamatrix_route) {
+    auto context = createRecognitionContext();
+    auto settings = createScannerSettings(PRESET_SINGLE_FRAME_MODE);
+    settings->setEnabledSymbologyMask(symbologyBit(SymbologyType::DataMatrix));
+    settings->setColorInvertedMask(0);
+    settings->setEngineRoute(SymbologyType::DataMatrix, datamatrix_route);
+    // Room for more codes than the frame holds, so the libdmtx fallback searches the whole image
+    settings->setMaxCodesPerFrame(4);
+    settings->setSearchWholeImage(true);
+    settings->setPreprocessingStages({});
+
+    BarcodeScanner scanner(context, settings);
+    context->startNewFrameSequence();
+    std::vector<BarcodeResult> results;
+    scanner.processFrame(createImageDescription(frame), results);
+    return results;
+}
+
+// libdmtx counts rows from the bottom; its location must still be the
+// placed one, or it is not merged with ZXing's result of the same code
+static void testDataMatrixOffCentreIsReportedOnce() {
+    cv::Rect placed;
+    cv::Mat frame = renderFrame(ZXing::BarcodeFormat::DataMatrix, DATAMATRIX_TEXT, 6, cv::Size(640, 480),
+                                cv::Point(260, 40), placed);
+
+    std::vector<BarcodeResult> libdmtx_only = scan(frame, {ENGINE_LIBDMTX});
+    CHECK(libdmtx_only.size() == 1);
+    CHECK(libdmtx_only[0].data == DATAMATRIX_TEXT);
+    cv::Rect overlap = libdmtx_only[0].location & placed;
+    CHECK(overlap.area() * 2 >= libdmtx_only[0].location.area());
+
+    std::vector<BarcodeResult> both = scan(frame, {ENGINE_ZXING, ENGINE_LIBDMTX});
+    CHECK(both.size() == 1);
+    CHECK(both[0].data == DATAMATRIX_TEXT);
+}
+
+// Both settings objects go through the same setters, so they reach the
+// same generation; the shared cache must still keep their results apart
+static void testResultCacheIsNotSharedBetweenSettings() {
+    cv::Rect placed;
+    cv::Mat frame = renderFrame(ZXing::BarcodeFormat::DataMatrix, DATAMATRIX_TEXT, 6, cv::Size(640, 480),
+                                cv::Point(200, 150), placed);
+
+    auto context = createRecognitionContext();
+    ResultCacheOptions cache_options = defaultResultCacheOptions();
+    cache_options.verify = false;
+    context->enableResultCache(cache_options);
+    context->startNewFrameSequence();
+
+    auto makeSettings = [](SymbologyType symbology) {
+        auto settings = createScannerSettings(PRESET_SINGLE_FRAME_MODE);
+        settings->setEnabledSymbologyMask(symbologyBit(symbology));
+        settings->setColorInvertedMask(0);
+        settings->setPreprocessingStages({});
+        return settings;
+    };
+    auto datamatrix_settings = makeSettings(SymbologyType::DataMatrix);
+    auto qr_settings = makeSettings(SymbologyType::QRCode);
+    CHECK(datamatrix_settings->getGeneration() == qr_settings->getGeneration());
+
+    BarcodeScanner datamatrix_scanner(context, datamatrix_settings);
+    BarcodeScanner qr_scanner(context, qr_settings);
+    std::vector<BarcodeResult> results;
+    datamatrix_scanner.processFrame(createImageDescription(frame), results);
+    CHECK(results.size() == 1);
+
+    qr_scanner.processFrame(createImageDescription(frame), results);
+    CHECK(results.empty());
+    CHECK(context->getResultCacheStatistics().hits == 0);
+
+    // A copy with the same settings may reuse the entry
+    BarcodeScanner copy_scanner(context, std::make_shared<BarcodeScannerSettings>(*datamatrix_settings));
+    copy_scanner.processFrame(createImageDescription(frame), results);
+    CHECK(results.size() == 1);
+    CHECK(context->getResultCacheStatistics().hits == 1);
+}
+
+// Tile workers decode on threads of their own; every tile's decode still
+// shows up in the frame's trace
+static void testTiledFrameIsTraced() {
+    cv::Rect placed;
+    cv::Mat frame = renderFrame(ZXing::BarcodeFormat::DataMatrix, DATAMATRIX_TEXT, 6, cv::Size(1280, 960),
+                                cv::Point(700, 500), placed);
+
+    auto context = createRecognitionContext();
+    auto settings = createScannerSettings(PRESET_SINGLE_FRAME_MODE);
+    settings->setEnabledSymbologyMask(symbologyBit(SymbologyType::DataMatrix));
+    settings->setColorInvertedMask(0);
+    settings->setMaxCodesPerFrame(4);
+    settings->setPreprocessingStages({});
+    TilingOptions tiling = defaultTilingOptions();
+    tiling.expected_symbol_size = 200;
+    tiling.symbols_per_tile = 2;
+    tiling.min_tile_size = 256;
+    tiling.max_workers = 2;
+    settings->setTiling(tiling);
+    CHECK(computeTileGrid(frame.size(), tiling).size() > 1);
+
+    BarcodeScanner scanner(context, settings);
+    size_t zxing_spans = 0;
+    scanner.setFrameTraceCallback([&](const FrameTrace& trace) {
+        for (const TraceSpan& span : trace.spans) {
+            if (span.stage == SCAN_STAGE_ZXING) ++zxing_spans;
+        }
+    });
+    context->startNewFrameSequence();
+    std::vector<BarcodeResult> results;
+    scanner.processFrame(createImageDescription(frame), results);
+    CHECK(results.size() == 1);
+    CHECK(zxing_spans >= computeTileGrid(frame.size(), tiling).size());
+}
+
+// A stride shorter than a row is reported, never thrown out of the scanner
+static void testShortRowBytesIsInvalidImage() {
+    std::vector<uint8_t> pixels(64 * 48 * 3, 200);
+    ImageDescription desc = createImageDescriptionView(pixels.data(), 64, 48, 100, PIXEL_FORMAT_BGR);
+    CHECK(desc.image_data.empty());
+    CHECK(!createImageDescriptionView(pixels.data(), 64, 48, 0, PIXEL_FORMAT_BGR).image_data.empty());
+
+    auto context = createRecognitionContext();
+    context->startNewFrameSequence();
+    BarcodeScanner scanner(context, createScannerSettings(PRESET_SINGLE_FRAME_MODE));
+    CHECK(scanner.processFrame(pixels.data(), 64, 48, 100, PIXEL_FORMAT_BGR) == SCAN_INVALID_IMAGE);
+    CHECK(scanner.processFrame(pixels.data(), 64, 48, -1, PIXEL_FORMAT_BGR) == SCAN_INVALID_IMAGE);
+    CHECK(scanner.processFrame(desc) == SCAN_INVALID_IMAGE);
+}
+
+// A bad image description is the caller's mistake, not a processing error
+static void testBatchRejectsNegativeSize() {
+    bs_scanner* scanner = nullptr;
+    CHECK(bs_scanner_create(nullptr, &scanner) == BS_OK);
+    std::vector<uint8_t> pixels(64 * 48, 200);
+    bs_image image = {pixels.data(), 64, -48, 0, BS_PIXEL_FORMAT_GRAY};
+    bs_result results[4];
+    char text[256];
+    bs_result_sink sink = {};
+    sink.results = results;
+    sink.result_capacity = 4;
+    sink.text = text;
+    sink.text_capacity = sizeof(text);
+    CHECK(bs_scan_batch(scanner, &image, 1, &sink) == BS_INVALID_ARGUMENT);
+
+    image.height = 48;
+    CHECK(bs_scan_batch(scanner, &image, 1, &sink) == BS_OK);
+    bs_scanner_destroy(scanner);
+}
+
+int main() {
+    BarcodeLogger::instance().setLevel(LOG_LEVEL_WARNING);
+    testDataMatrixOffCentreIsReportedOnce();
+    testResultCacheIsNotSharedBetweenSettings();
+    testTiledFrameIsTraced();
+    testShortRowBytesIsInvalidImage();
+    testBatchRejectsNegativeSize();
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,238 @@
+// BoundedQueue under contention, and the stream pipeline's drop policies
+// and shutdown. Exits non-zero on the first failed check.
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../barcode_logger.h"
+#include "../barcode_queue.h"
+#include "../barcode_stream.h"
+#include "test_check.h"
+
+struct Item {
+    int producer;
+    int sequence;
+};
+
+// Every item arrives exactly once, and each consumer sees every producer's
+// items in the order they were pushed
+static void testQueueUnderContention() {
+    const int producers = 4;
+    const int consumers = 4;
+    const int items_per_producer = 20000;
+    BoundedQueue<Item> queue(6);
+    CHECK(queue.capacity() == 8);
+
+    std::vector<std::atomic<int>> seen(producers * items_per_producer);
+    for (auto& count : seen) count = 0;
+    std::atomic<int> popped(0);
+    std::atomic<bool> out_of_order(false);
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p, items_per_producer] {
+            int idle_rounds = 0;
+            for (int i = 0; i < items_per_producer; ++i) {
+                Item item{p, i};
+                while (!queue.tryPush(item)) backOff(idle_rounds);
+                idle_rounds = 0;
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            std::vector<int> last(producers, -1);
+            int idle_rounds = 0;
+            while (popped.load() < producers * items_per_producer) {
+                Item item;
+                if (!queue.tryPop(item)) {
+                    backOff(idle_rounds);
+                    continue;
+                }
+                idle_rounds = 0;
+                popped.fetch_add(1);
+                seen[item.producer * items_per_producer + item.sequence].fetch_add(1);
+                if (item.sequence <= last[item.producer]) out_of_order = true;
+                last[item.producer] = item.sequence;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    CHECK(popped.load() == producers * items_per_producer);
+    for (const auto& count : seen) CHECK(count.load() == 1);
+    CHECK(!out_of_order.load());
+    CHECK(queue.empty());
+}
+
+static void testQueueFullAndEmpty() {
+    BoundedQueue<int> queue(4);
+    int value = 0;
+    CHECK(!queue.tryPop(value));
+    for (int i = 0; i < 4; ++i) {
+        value = i;
+        CHECK(queue.tryPush(value));
+    }
+    value = 4;
+    CHECK(!queue.tryPush(value));
+    CHECK(value == 4);  // Left alone when there was no room
+    CHECK(queue.size() == 4);
+    for (int i = 0; i < 4; ++i) {
+        CHECK(queue.tryPop(value));
+        CHECK(value == i);
+    }
+    CHECK(queue.empty());
+}
+
+// White frames, so decoding is quick and finds nothing; limit 0 never ends
+class BlankSource : public FrameSource {
+public:
+    BlankSource(uint64_t frame_limit, std::atomic<bool>& ended) : limit(frame_limit), frames(0), done(ended) {}
+
+    bool read(cv::Mat& frame) override {
+        if (limit != 0 && frames == limit) {
+            done = true;
+            return false;
+        }
+        ++frames;
+        frame = cv::Mat(48, 64, CV_8UC1, cv::Scalar(255));
+        return true;
+    }
+
+private:
+    uint64_t limit;
+    uint64_t frames;
+    std::atomic<bool>& done;
+};
+
+// Holds the sink thread until released
+class StalledSink {
+public:
+    StalledSink() : released(false) {}
+
+    void operator()(const StreamResult& result) {
+        std::unique_lock<std::mutex> lock(mutex);
+        released_cv.wait(lock, [this] { return released; });
+        delivered.push_back(result.frame_index);
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        released_cv.notify_all();
+    }
+
+    std::vector<uint64_t> delivered;  // Read once the pipeline has stopped
+
+private:
+    std::mutex mutex;
+    std::condition_variable released_cv;
+    bool released;
+};
+
+static uint64_t droppedFrames(const BarcodeStreamPipeline& pipeline) {
+    uint64_t dropped = 0;
+    for (int stage = 0; stage < STREAM_STAGE_COUNT; ++stage) {
+        dropped += pipeline.getStageStats(static_cast<StreamStage>(stage)).dropped;
+    }
+    return dropped;
+}
+
+static StreamPipelineOptions singleWorkerOptions(StreamDropPolicy policy) {
+    StreamPipelineOptions options = defaultStreamPipelineOptions();
+    options.decode_workers = 1;
+    options.queue_capacity = 2;
+    options.drop_policy = policy;
+    return options;
+}
+
+// Every frame read is either delivered or counted as dropped, and which
+// frames survive follows the policy
+static void testDropPolicyCounters(StreamDropPolicy policy) {
+    const uint64_t frame_count = 64;
+    std::atomic<bool> source_ended(false);
+    StalledSink stalled;
+    BarcodeStreamPipeline pipeline(std::unique_ptr<FrameSource>(new BlankSource(frame_count, source_ended)),
+                                   createRecognitionContext(), createScannerSettings(PRESET_SINGLE_FRAME_MODE),
+                                   [&stalled](const StreamResult& result) { stalled(result); },
+                                   singleWorkerOptions(policy));
+    pipeline.start();
+
+    if (policy == STREAM_BLOCK) {
+        // The source stalls with the sink, so it cannot run out first
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(!source_ended.load());
+    } else {
+        while (!source_ended.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stalled.release();
+    pipeline.wait();
+
+    uint64_t dropped = droppedFrames(pipeline);
+    CHECK(pipeline.getStageStats(STREAM_STAGE_CAPTURE).processed == frame_count);
+    CHECK(pipeline.getStageStats(STREAM_STAGE_SINK).processed == stalled.delivered.size());
+    CHECK(stalled.delivered.size() + dropped == frame_count);
+    for (size_t i = 1; i < stalled.delivered.size(); ++i) {
+        CHECK(stalled.delivered[i] > stalled.delivered[i - 1]);  // One worker keeps capture order
+    }
+
+    switch (policy) {
+        case STREAM_DROP_NEWEST:
+            CHECK(dropped > 0);
+            CHECK(stalled.delivered.front() == 0);
+            break;
+        case STREAM_DROP_OLDEST:
+            CHECK(dropped > 0);
+            CHECK(stalled.delivered.back() == frame_count - 1);
+            break;
+        case STREAM_BLOCK:
+            CHECK(dropped == 0);
+            break;
+    }
+}
+
+// Frames already in the queues when stop() is called still reach the sink
+static void testStopDeliversQueuedFrames() {
+    std::atomic<bool> source_ended(false);
+    StalledSink stalled;
+    BarcodeStreamPipeline pipeline(std::unique_ptr<FrameSource>(new BlankSource(0, source_ended)),
+                                   createRecognitionContext(), createScannerSettings(PRESET_SINGLE_FRAME_MODE),
+                                   [&stalled](const StreamResult& result) { stalled(result); },
+                                   singleWorkerOptions(STREAM_BLOCK));
+    pipeline.start();
+    // Long enough for every queue to fill up behind the sink
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::thread stopper([&pipeline] { pipeline.stop(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stalled.release();
+    stopper.join();
+
+    CHECK(!pipeline.isRunning());
+    uint64_t read = pipeline.getStageStats(STREAM_STAGE_CAPTURE).processed;
+    CHECK(stalled.delivered.size() > 1);
+    // At most the frame capture had in hand when it gave up
+    CHECK(droppedFrames(pipeline) <= 1);
+    CHECK(stalled.delivered.size() + droppedFrames(pipeline) == read);
+    for (int stage = STREAM_STAGE_CONVERT; stage < STREAM_STAGE_COUNT; ++stage) {
+        CHECK(pipeline.getStageStats(static_cast<StreamStage>(stage)).queue_depth == 0);
+    }
+}
+
+int main() {
+    BarcodeLogger::instance().setLevel(LOG_LEVEL_WARNING);
+    testQueueFullAndEmpty();
+    testQueueUnderContention();
+    testDropPolicyCounters(STREAM_DROP_NEWEST);
+    testDropPolicyCounters(STREAM_DROP_OLDEST);
+    testDropPolicyCounters(STREAM_BLOCK);
+    testStopDeliversQueuedFrames();
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}
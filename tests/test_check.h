@@ -0,0 +1,17 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+
+// The tests are plain executables run by ctest; the first failed check
+// prints its location and exits non-zero
+#define CHECK(condition)                                                            \
+    do {                                                                            \
+        if (!(condition)) {                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #condition << std::endl; \
+            std::exit(1);                                                           \
+        }                                                                           \
+    } while (0)
+
+#endif // TEST_CHECK_H